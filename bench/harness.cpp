@@ -0,0 +1,336 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../common/stats.h"
+
+// Shared benchmark harness: reproducible key workloads, a probe that times a
+// loop of operations, and a runner that executes every case in a forked
+// child so that each one reports its own peak RSS. Results are JSON.
+namespace bench {
+
+using u64 = unsigned long long;
+
+enum class Workload { uniform, sorted, zipf };
+
+inline constexpr Workload kAllWorkloads[] = {Workload::uniform, Workload::sorted, Workload::zipf};
+
+constexpr std::string_view name(Workload w) noexcept {
+  switch (w) {
+    case Workload::uniform: return "uniform";
+    case Workload::sorted: return "sorted";
+    case Workload::zipf: return "zipf";
+  }
+  return "?";
+}
+
+// Maps a 64-bit draw onto [0, n) without modulo bias worth measuring.
+inline u64 below(std::mt19937_64& rng, u64 n) noexcept {
+  return static_cast<u64>((static_cast<unsigned __int128>(rng()) * n) >> 64);
+}
+
+// Zipfian ranks in [0, n) with skew theta (Gray et al., as used by YCSB).
+// Rank 0 is the most frequent.
+class Zipf {
+  u64 n_;
+  double theta_, alpha_, zetan_, eta_;
+
+  static double zeta(u64 n, double theta) {
+    double s = 0;
+    for (u64 i = 1; i <= n; ++i) s += 1.0 / std::pow(static_cast<double>(i), theta);
+    return s;
+  }
+
+public:
+  explicit Zipf(u64 n, double theta = 0.99)
+    : n_(n), theta_(theta), alpha_(1.0 / (1.0 - theta)), zetan_(zeta(n, theta)),
+      eta_((1.0 - std::pow(2.0 / static_cast<double>(n), 1.0 - theta)) / (1.0 - zeta(2, theta) / zetan_)) {}
+
+  u64 operator()(std::mt19937_64& rng) const {
+    const double u = std::generate_canonical<double, 64>(rng);
+    const double uz = u * zetan_;
+    if (uz < 1.0) return 0;
+    if (uz < 1.0 + std::pow(0.5, theta_)) return 1;
+    return std::min<u64>(n_ - 1, static_cast<u64>(static_cast<double>(n_) * std::pow(eta_ * u - eta_ + 1.0, alpha_)));
+  }
+};
+
+// n keys drawn from w. Sorted keys are 0..n-1; Zipfian ranks are scattered
+// over the key space by an odd multiplier, so hot keys are not adjacent.
+inline std::vector<u64> make_keys(Workload w, std::size_t n, u64 seed) {
+  std::mt19937_64 rng(seed);
+  std::vector<u64> keys(n);
+  switch (w) {
+    case Workload::uniform:
+      for (auto& k : keys) k = rng();
+      break;
+    case Workload::sorted:
+      for (std::size_t i = 0; i < n; ++i) keys[i] = i;
+      break;
+    case Workload::zipf: {
+      const Zipf z(std::max<u64>(n, 2));
+      for (auto& k : keys) k = z(rng) * 0x9E3779B97F4A7C15ULL;
+      break;
+    }
+  }
+  return keys;
+}
+
+// Keeps a value alive without emitting code for it.
+template <class T>
+inline void keep(const T& x) noexcept { asm volatile("" : : "r,m"(x) : "memory"); }
+
+// Times one loop of operations. A case runs twice: once with the loop timed
+// as a whole for throughput, once with every operation timed on its own for
+// the latency percentiles, which therefore include one clock read (~20 ns).
+class Probe {
+  using clock = std::chrono::steady_clock;
+  bool per_op_;
+  std::size_t ops_ = 0;
+  double seconds_ = 0;
+  std::vector<std::uint32_t> lat_;
+  container_stats stats_{};
+  bool has_stats_ = false;
+
+public:
+  explicit Probe(bool per_op) noexcept : per_op_(per_op) {}
+
+  template <class F>
+  void measure(std::size_t ops, F&& op) {
+    if (ops_) throw std::logic_error("bench::Probe::measure called twice");
+    ops_ = ops;
+    if (per_op_) {
+      lat_.reserve(ops);
+      for (std::size_t i = 0; i < ops; ++i) {
+        const auto t0 = clock::now();
+        if constexpr (std::is_void_v<std::invoke_result_t<F&, std::size_t>>) op(i);
+        else keep(op(i));
+        const auto t1 = clock::now();
+        lat_.push_back(static_cast<std::uint32_t>(std::min<long long>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count(), UINT32_MAX)));
+      }
+      return;
+    }
+    const auto t0 = clock::now();
+    for (std::size_t i = 0; i < ops; ++i) {
+      if constexpr (std::is_void_v<std::invoke_result_t<F&, std::size_t>>) op(i);
+      else keep(op(i));
+    }
+    seconds_ = std::chrono::duration<double>(clock::now() - t0).count();
+  }
+
+  // Records the container's counters after the measured loop; they appear
+  // in the JSON when the build has DSA_STATS.
+  template <class C>
+  void record(const C& c) {
+    if constexpr (requires { { c.stats() } -> std::convertible_to<container_stats>; }) {
+      stats_ = c.stats();
+      has_stats_ = stats_counter::enabled;
+    }
+  }
+
+  [[nodiscard]] std::size_t ops() const noexcept { return ops_; }
+  [[nodiscard]] bool has_stats() const noexcept { return has_stats_; }
+  [[nodiscard]] const container_stats& stats() const noexcept { return stats_; }
+  [[nodiscard]] double ops_per_sec() const noexcept { return seconds_ > 0 ? ops_ / seconds_ : 0; }
+
+  [[nodiscard]] double percentile(double p) {
+    if (lat_.empty()) return 0;
+    const std::size_t i = std::min(lat_.size() - 1, static_cast<std::size_t>(p * lat_.size()));
+    std::nth_element(lat_.begin(), lat_.begin() + i, lat_.end());
+    return lat_[i];
+  }
+};
+
+struct Case {
+  std::string structure;
+  std::string op;
+  std::vector<Workload> workloads;
+  std::function<void(Probe&, const std::vector<u64>&)> body;
+};
+
+struct Result {
+  std::size_t ops = 0;
+  double ops_per_sec = 0, p50_ns = 0, p99_ns = 0;
+  long peak_rss_kb = 0;
+  bool has_stats = false;
+  container_stats stats{};
+};
+
+struct Options {
+  std::size_t n = 1'000'000;
+  u64 seed = 42;
+  std::vector<Workload> workloads{std::begin(kAllWorkloads), std::end(kAllWorkloads)};
+  std::string filter;
+  std::string out;
+  bool fork = true;
+};
+
+inline long peak_rss_kb() noexcept {
+  rusage ru{};
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_maxrss;
+}
+
+inline Result run_here(const Case& c, Workload w, const Options& opt) {
+  Result r;
+  {
+    const auto keys = make_keys(w, opt.n, opt.seed);
+    Probe p(false);
+    c.body(p, keys);
+    r.ops = p.ops();
+    r.ops_per_sec = p.ops_per_sec();
+    r.has_stats = p.has_stats();
+    r.stats = p.stats();
+  }
+  r.peak_rss_kb = peak_rss_kb();
+  const auto keys = make_keys(w, opt.n, opt.seed);
+  Probe p(true);
+  c.body(p, keys);
+  r.p50_ns = p.percentile(0.50);
+  r.p99_ns = p.percentile(0.99);
+  return r;
+}
+
+// Runs the case in a child process so that its peak RSS is its own; a
+// crashing case is reported instead of taking the whole suite down.
+inline Result run_isolated(const Case& c, Workload w, const Options& opt) {
+  if (!opt.fork) return run_here(c, w, opt);
+  int fd[2];
+  if (pipe(fd) != 0) throw std::runtime_error("bench: pipe failed");
+  std::fflush(nullptr);
+  const pid_t pid = ::fork();
+  if (pid < 0) throw std::runtime_error("bench: fork failed");
+  if (pid == 0) {
+    close(fd[0]);
+    int status = 0;
+    try {
+      const Result r = run_here(c, w, opt);
+      status = write(fd[1], &r, sizeof r) == static_cast<ssize_t>(sizeof r) ? 0 : 1;
+    } catch (const std::exception& e) {
+      std::fprintf(stderr, "%s\n", e.what());
+      status = 1;
+    } catch (...) {
+      status = 1;
+    }
+    _exit(status);
+  }
+  close(fd[1]);
+  Result r;
+  const ssize_t got = read(fd[0], &r, sizeof r);
+  close(fd[0]);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  if (WIFSIGNALED(status)) throw std::runtime_error("killed by signal " + std::to_string(WTERMSIG(status)));
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) throw std::runtime_error("exited with status " + std::to_string(WEXITSTATUS(status)));
+  if (got != static_cast<ssize_t>(sizeof r)) throw std::runtime_error("no result from the child");
+  return r;
+}
+
+inline std::string json_escape(std::string_view s) {
+  std::string out;
+  for (char ch : s) {
+    if (ch == '"' || ch == '\\') out += '\\';
+    out += ch;
+  }
+  return out;
+}
+
+// Parses "-n N -s SEED -w uniform,zipf -f filter -o out.json --no-fork".
+inline Options parse_options(int argc, char** argv) {
+  Options opt;
+  auto number = [](std::string_view s) {
+    u64 v = 0;
+    const auto [p, ec] = std::from_chars(s.data(), s.data() + s.size(), v);
+    if (ec != std::errc{} || p != s.data() + s.size()) throw std::invalid_argument("bench: bad number '" + std::string(s) + "'");
+    return v;
+  };
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view a = argv[i];
+    auto value = [&]() -> std::string_view {
+      if (i + 1 >= argc) throw std::invalid_argument("bench: missing value after " + std::string(a));
+      return argv[++i];
+    };
+    if (a == "-n") opt.n = number(value());
+    else if (a == "-s") opt.seed = number(value());
+    else if (a == "-f") opt.filter = value();
+    else if (a == "-o") opt.out = value();
+    else if (a == "--no-fork") opt.fork = false;
+    else if (a == "-w") {
+      opt.workloads.clear();
+      std::string_view list = value();
+      while (!list.empty()) {
+        const auto comma = list.find(',');
+        const auto item = list.substr(0, comma);
+        const auto it = std::ranges::find(kAllWorkloads, item, [](Workload w) { return name(w); });
+        if (it == std::end(kAllWorkloads)) throw std::invalid_argument("bench: unknown workload '" + std::string(item) + "'");
+        opt.workloads.push_back(*it);
+        list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+      }
+    } else {
+      throw std::invalid_argument("usage: " + std::string(argv[0]) + " [-n N] [-s seed] [-w uniform,sorted,zipf] [-f filter] [-o out.json] [--no-fork]");
+    }
+  }
+  if (opt.n < 2) throw std::invalid_argument("bench: -n must be at least 2");
+  return opt;
+}
+
+// Runs every case whose "structure/op" contains the filter, on each of its
+// workloads that was requested, and writes one JSON document. A case that
+// fails gets an "error" entry in place of its numbers and the rest still run;
+// the result is nonzero if any case failed.
+inline int run_suite(const std::vector<Case>& cases, const Options& opt, std::string_view build) {
+  std::FILE* out = opt.out.empty() ? stdout : std::fopen(opt.out.c_str(), "w");
+  if (!out) throw std::runtime_error("bench: cannot open " + opt.out);
+  std::fprintf(out, "{\n  \"build\": \"%s\",\n  \"n\": %zu,\n  \"seed\": %llu,\n  \"benchmarks\": [",
+               json_escape(build).c_str(), opt.n, opt.seed);
+  bool first = true;
+  int failed = 0;
+  for (const Case& c : cases) {
+    if (!opt.filter.empty() && (c.structure + "/" + c.op).find(opt.filter) == std::string::npos) continue;
+    for (Workload w : c.workloads) {
+      if (std::ranges::find(opt.workloads, w) == opt.workloads.end()) continue;
+      std::fprintf(stderr, "%s/%s/%s\n", c.structure.c_str(), c.op.c_str(), std::string(name(w)).c_str());
+      std::fprintf(out, "%s\n    {\"structure\": \"%s\", \"op\": \"%s\", \"workload\": \"%s\"", first ? "" : ",",
+                   json_escape(c.structure).c_str(), json_escape(c.op).c_str(), std::string(name(w)).c_str());
+      first = false;
+      Result r;
+      try {
+        r = run_isolated(c, w, opt);
+      } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s/%s/%s: %s\n", c.structure.c_str(), c.op.c_str(), std::string(name(w)).c_str(), e.what());
+        std::fprintf(out, ", \"error\": \"%s\"}", json_escape(e.what()).c_str());
+        ++failed;
+        continue;
+      }
+      std::fprintf(out, ", \"ops\": %zu, \"ops_per_sec\": %.1f, \"p50_ns\": %.0f, \"p99_ns\": %.0f, \"peak_rss_kb\": %ld",
+                   r.ops, r.ops_per_sec, r.p50_ns, r.p99_ns, r.peak_rss_kb);
+      if (r.has_stats) {
+        std::ostringstream os;
+        os << r.stats;
+        std::fprintf(out, ", \"stats\": %s", os.str().c_str());
+      }
+      std::fputc('}', out);
+    }
+  }
+  std::fprintf(out, "\n  ]\n}\n");
+  if (out != stdout) std::fclose(out);
+  if (failed) std::fprintf(stderr, "bench: %d case(s) failed\n", failed);
+  return failed ? 1 : 0;
+}
+
+}  // namespace bench
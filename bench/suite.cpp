@@ -0,0 +1,169 @@
+#include <bits/stdc++.h>
+#include "harness.cpp"
+#include "convex-hull.cpp"
+#include "binary_search_tree.cpp"
+#include "sort.cpp"
+#include "heap.cpp"
+#include "avl.cpp"
+#include "bplus_tree.cpp"
+#include "persistent_avl.cpp"
+#include "leftist_heap.cpp"
+#include "skew_heap.cpp"
+#include "pairing_heap.cpp"
+
+#ifndef DSA_BUILD
+#define DSA_BUILD "unknown"
+#endif
+
+using bench::Case;
+using bench::Probe;
+using bench::u64;
+using Keys = std::vector<u64>;
+
+constexpr std::size_t kBlock = 4096;
+
+// Counters from filling a container are not part of the measured op.
+template <class C>
+void reset_stats(C& c) {
+  if constexpr (requires { c.reset_stats(); }) c.reset_stats();
+}
+
+static std::vector<bench::Workload> all() { return {std::begin(bench::kAllWorkloads), std::end(bench::kAllWorkloads)}; }
+
+// push: n pushes into an empty queue. pop: n pops from a full one.
+template <class Q, class Push, class Pop>
+void add_queue(std::vector<Case>& cases, std::string name, Push push, Pop pop) {
+  cases.push_back({name, "push", all(), [=](Probe& p, const Keys& k) {
+    Q q;
+    p.measure(k.size(), [&](std::size_t i) { push(q, k[i]); });
+    p.record(q);
+  }});
+  cases.push_back({name, "pop", all(), [=](Probe& p, const Keys& k) {
+    Q q;
+    for (u64 x : k) push(q, x);
+    reset_stats(q);
+    p.measure(k.size(), [&](std::size_t) { return pop(q); });
+    p.record(q);
+  }});
+}
+
+// n singleton heaps melded pairwise in rounds down to one; one op per meld.
+template <class H>
+void add_meld(std::vector<Case>& cases, std::string name) {
+  cases.push_back({name, "meld", all(), [](Probe& p, const Keys& k) {
+    std::vector<H> heaps(k.size());
+    for (std::size_t i = 0; i < k.size(); ++i) heaps[i].push(k[i]);
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> plan;
+    for (std::size_t live = k.size(); live > 1; live = (live + 1) / 2)
+      for (std::size_t i = 0; i < live / 2; ++i) plan.emplace_back(i, live - 1 - i);
+    p.measure(plan.size(), [&](std::size_t i) { heaps[plan[i].first].merge(heaps[plan[i].second]); });
+  }});
+}
+
+template <class H>
+void add_meldable(std::vector<Case>& cases, std::string name) {
+  add_queue<H>(cases, name, [](H& h, u64 x) { h.push(x); }, [](H& h) { return h.extractTop(); });
+  add_meld<H>(cases, name);
+}
+
+// insert: n upserts into an empty map. find and erase run over the keys in a
+// shuffled order on a full map.
+template <class M>
+void add_map(std::vector<Case>& cases, std::string name, bool with_erase) {
+  auto shuffled = [](const Keys& k) {
+    Keys s(k);
+    std::shuffle(s.begin(), s.end(), std::mt19937_64(k.size()));
+    return s;
+  };
+  cases.push_back({name, "insert", all(), [](Probe& p, const Keys& k) {
+    M m;
+    p.measure(k.size(), [&](std::size_t i) { m.insert_or_assign(k[i], k[i]); });
+    p.record(m);
+  }});
+  cases.push_back({name, "find", all(), [=](Probe& p, const Keys& k) {
+    M m;
+    for (u64 x : k) m.insert_or_assign(x, x);
+    const Keys s = shuffled(k);
+    reset_stats(m);
+    p.measure(s.size(), [&](std::size_t i) { return m.contains(s[i]); });
+    p.record(m);
+  }});
+  if (!with_erase) return;
+  cases.push_back({name, "erase", all(), [=](Probe& p, const Keys& k) {
+    M m;
+    for (u64 x : k) m.insert_or_assign(x, x);
+    const Keys s = shuffled(k);
+    reset_stats(m);
+    p.measure(s.size(), [&](std::size_t i) { return m.erase(s[i]); });
+    p.record(m);
+  }});
+}
+
+static std::vector<Case> make_cases() {
+  std::vector<Case> cases;
+  const std::vector<bench::Workload> uniform{bench::Workload::uniform};
+
+  cases.push_back({"LinkedList", "push_back", uniform, [](Probe& p, const Keys& k) {
+    LinkedList<u64> l;
+    p.measure(k.size(), [&](std::size_t i) { l.push_back(k[i]); });
+  }});
+  cases.push_back({"LinkedList", "pop_front", uniform, [](Probe& p, const Keys& k) {
+    LinkedList<u64> l;
+    for (u64 x : k) l.push_back(x);
+    p.measure(k.size(), [&](std::size_t) { u64 x = 0; l.pop_front(x); return x; });
+  }});
+
+  // One op sorts one block of kBlock keys.
+  cases.push_back({"quicksort", "sort_4k", all(), [](Probe& p, const Keys& k) {
+    Keys a(k);
+    p.measure(a.size() / kBlock, [&](std::size_t i) {
+      quicksort(a.begin() + i * kBlock, a.begin() + (i + 1) * kBlock);
+      return a[i * kBlock];
+    });
+  }});
+
+  // One op builds the hull of kBlock points taken from the key bits.
+  cases.push_back({"Graham", "hull_4k", uniform, [](Probe& p, const Keys& k) {
+    std::vector<Point> pts;
+    pts.reserve(k.size());
+    for (u64 x : k) pts.emplace_back(double(x & 0xffffffff), double(x >> 32));
+    p.measure(pts.size() / kBlock, [&](std::size_t i) {
+      return Graham({pts.begin() + i * kBlock, pts.begin() + (i + 1) * kBlock}).size();
+    });
+  }});
+
+  // The unbalanced tree is left out of the sorted workload: it degenerates
+  // into a list, n inserts take O(n^2) and the recursion depth is n.
+  const std::vector<bench::Workload> unsorted{bench::Workload::uniform, bench::Workload::zipf};
+  cases.push_back({"BinaryTree", "insert", unsorted, [](Probe& p, const Keys& k) {
+    BinaryTree<u64> t;
+    p.measure(k.size(), [&](std::size_t i) { t.insert(k[i]); });
+    p.record(t);
+  }});
+  cases.push_back({"BinaryTree", "find", unsorted, [](Probe& p, const Keys& k) {
+    BinaryTree<u64> t;
+    for (u64 x : k) t.insert(x);
+    t.reset_stats();
+    p.measure(k.size(), [&](std::size_t i) { return t.contains(k[k.size() - 1 - i]); });
+    p.record(t);
+  }});
+
+  add_queue<Heap<u64>>(cases, "Heap", [](auto& h, u64 x) { h.push(x); }, [](auto& h) { return h.pop(); });
+  add_meldable<LeftistHeap<u64>>(cases, "LeftistHeap");
+  add_meldable<SkewHeap<u64>>(cases, "SkewHeap");
+  add_meldable<PairingHeap<u64>>(cases, "PairingHeap");
+
+  add_map<avl_tree<u64, u64>>(cases, "avl_tree", true);
+  add_map<bplus_tree<u64, u64>>(cases, "bplus_tree", true);
+  add_map<persistent_avl_tree<u64, u64>>(cases, "persistent_avl_tree", true);
+  return cases;
+}
+
+int main(int argc, char** argv) {
+  try {
+    return bench::run_suite(make_cases(), bench::parse_options(argc, argv), DSA_BUILD);
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Epoch-based reclamation for structures that readers traverse without locks.
+// A thread pins itself with an epoch_guard for the duration of an operation;
+// memory unlinked by a writer is handed to epoch_retire() and freed only once
+// every thread pinned at the time has unpinned. Pinning writes the calling
+// thread's own record, so readers share no cache line with each other or with
+// writers, unlike a shared refcount.
+//
+// One process-wide domain with a global epoch: retired memory is tagged with
+// the epoch current when it was retired and freed once the epoch has moved
+// two steps past it, which the epoch does only after every pinned thread has
+// observed the latest value.
+namespace epoch_detail {
+
+inline constexpr std::uint64_t kPinned = 1;  // low bit of a record's state
+inline constexpr std::size_t kCollectEvery = 64;
+
+struct alignas(64) record {
+  std::atomic<std::uint64_t> state{0};  // epoch << 1 | kPinned while pinned
+  std::atomic<bool> in_use{true};
+  record* next = nullptr;
+};
+
+struct retired {
+  void* p;
+  void (*destroy)(void*);
+  std::uint64_t epoch;
+};
+
+struct domain {
+  std::atomic<std::uint64_t> epoch{0};
+  std::atomic<record*> records{nullptr};  // push-only; records are reused, never freed
+  std::mutex orphans_mu;
+  std::vector<retired> orphans;  // left behind by threads that exited
+};
+
+// Never destroyed: threads may still retire memory during static destruction.
+inline domain& global() {
+  static domain* d = new domain;
+  return *d;
+}
+
+inline record* acquire_record() {
+  domain& d = global();
+  for (record* r = d.records.load(std::memory_order_acquire); r; r = r->next) {
+    bool free = false;
+    if (!r->in_use.load(std::memory_order_relaxed) && r->in_use.compare_exchange_strong(free, true)) return r;
+  }
+  record* r = new record;
+  r->next = d.records.load(std::memory_order_relaxed);
+  while (!d.records.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed)) {}
+  return r;
+}
+
+// Moves the global epoch forward if every pinned thread has seen it.
+inline std::uint64_t try_advance() {
+  domain& d = global();
+  std::uint64_t e = d.epoch.load();
+  for (record* r = d.records.load(std::memory_order_acquire); r; r = r->next) {
+    const std::uint64_t s = r->state.load();
+    if ((s & kPinned) && (s >> 1) != e) return e;
+  }
+  return d.epoch.compare_exchange_strong(e, e + 1) ? e + 1 : e;
+}
+
+// Frees the prefix of bag (oldest first) retired at least two epochs ago.
+inline void free_expired(std::vector<retired>& bag, std::uint64_t now) {
+  std::size_t n = 0;
+  while (n < bag.size() && bag[n].epoch + 2 <= now) ++n;
+  for (std::size_t i = 0; i < n; ++i) bag[i].destroy(bag[i].p);
+  bag.erase(bag.begin(), bag.begin() + static_cast<std::ptrdiff_t>(n));
+}
+
+struct local {
+  record* rec = nullptr;
+  unsigned depth = 0;
+  std::vector<retired> garbage;
+
+  void collect() {
+    const std::uint64_t now = try_advance();
+    free_expired(garbage, now);
+    domain& d = global();
+    std::unique_lock lk(d.orphans_mu, std::try_to_lock);
+    if (lk && !d.orphans.empty()) free_expired(d.orphans, now);
+  }
+
+  ~local() {
+    if (!garbage.empty()) {
+      collect();
+      collect();
+    }
+    if (!garbage.empty()) {
+      domain& d = global();
+      std::lock_guard lk(d.orphans_mu);
+      d.orphans.insert(d.orphans.end(), garbage.begin(), garbage.end());
+    }
+    if (rec) {
+      rec->state.store(0, std::memory_order_release);
+      rec->in_use.store(false, std::memory_order_release);
+    }
+  }
+};
+
+inline local& self() {
+  thread_local local l;
+  return l;
+}
+
+}  // namespace epoch_detail
+
+// Pins the calling thread for its lifetime. Guards nest.
+class epoch_guard {
+  epoch_detail::local& l_ = epoch_detail::self();
+
+public:
+  epoch_guard() {
+    if (l_.depth++) return;
+    if (!l_.rec) l_.rec = epoch_detail::acquire_record();
+    // Sequentially consistent, so the pin is ordered before every load the
+    // guarded operation makes.
+    l_.rec->state.exchange(epoch_detail::global().epoch.load() << 1 | epoch_detail::kPinned);
+  }
+  ~epoch_guard() {
+    if (--l_.depth == 0) l_.rec->state.store(0, std::memory_order_release);
+  }
+  epoch_guard(const epoch_guard&) = delete;
+  epoch_guard& operator=(const epoch_guard&) = delete;
+};
+
+// Deletes p once no thread that might still hold it is pinned. p must
+// already be unreachable for threads that pin from now on.
+template <typename T>
+void epoch_retire(T* p) {
+  auto& l = epoch_detail::self();
+  l.garbage.push_back({p, [](void* q) { delete static_cast<T*>(q); }, epoch_detail::global().epoch.load()});
+  if (l.garbage.size() % epoch_detail::kCollectEvery == 0) l.collect();
+}
@@ -0,0 +1,279 @@
+#pragma once
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// On-disk form of an ordered container whose keys (and values) are
+// trivially copyable: the keys sorted in one flat array, the values in a
+// parallel array and a static index holding every kFanout-th key. A file is
+// queried in place through flat_snapshot, which maps it read-only and needs
+// no deserialization, or handed to a tree's load() to rebuild a mutable copy
+// in O(n).
+//
+// Layout, each section 64-byte aligned:
+//   header | keys[count] | values[count] | index[ceil(count / kFanout)]
+// Sets (T = void) have no values section. The header records element sizes
+// and a byte-order mark, so a file from another ABI is rejected, not misread.
+// The comparator is not stored: the reader must order keys like the writer.
+namespace flat_snapshot_format {
+
+inline constexpr char kMagic[8] = {'D', 'S', 'A', 'S', 'N', 'A', 'P', '1'};
+inline constexpr std::uint32_t kByteOrder = 0x01020304;
+inline constexpr std::uint64_t kAlign = 64;
+inline constexpr std::uint64_t kFanout = 64;
+
+struct header {
+  char magic[8];
+  std::uint32_t byte_order;
+  std::uint32_t fanout;
+  std::uint64_t count;
+  std::uint32_t key_size, key_align;
+  std::uint32_t value_size, value_align;
+  std::uint64_t keys_offset, values_offset, index_offset, file_size;
+};
+
+constexpr std::uint64_t align_up(std::uint64_t x) noexcept { return (x + kAlign - 1) & ~(kAlign - 1); }
+
+template <class T>
+inline constexpr std::uint32_t size_of = sizeof(T);
+template <>
+inline constexpr std::uint32_t size_of<void> = 0;
+template <class T>
+inline constexpr std::uint32_t align_of = alignof(T);
+template <>
+inline constexpr std::uint32_t align_of<void> = 0;
+
+template <class Key, class T>
+constexpr header layout(std::uint64_t count) noexcept {
+  header h{};
+  std::copy(std::begin(kMagic), std::end(kMagic), h.magic);
+  h.byte_order = kByteOrder;
+  h.fanout = kFanout;
+  h.count = count;
+  h.key_size = size_of<Key>;
+  h.key_align = align_of<Key>;
+  h.value_size = size_of<T>;
+  h.value_align = align_of<T>;
+  h.keys_offset = align_up(sizeof(header));
+  h.values_offset = align_up(h.keys_offset + count * h.key_size);
+  h.index_offset = align_up(h.values_offset + count * h.value_size);
+  h.file_size = h.index_offset + (count + kFanout - 1) / kFanout * h.key_size;
+  return h;
+}
+
+[[noreturn]] inline void fail(const std::string& what, const std::string& path) {
+  throw std::runtime_error("flat_snapshot: " + what + " '" + path + "': " + std::strerror(errno));
+}
+
+}  // namespace flat_snapshot_format
+
+template <class Key, class T>
+concept flat_storable = std::is_trivially_copyable_v<Key> && alignof(Key) <= flat_snapshot_format::kAlign &&
+                        (std::is_void_v<T> || (std::is_trivially_copyable_v<T> && alignof(T) <= flat_snapshot_format::kAlign));
+
+// Writes count elements that for_each(emit) produces in strictly increasing
+// key order, calling emit(key, value) (emit(key) for sets). for_each runs
+// twice for maps, once per array. The file is written next to path and
+// renamed over it only when complete, so a crash leaves the old file intact.
+template <class Key, class T, class ForEach>
+requires flat_storable<Key, T>
+void write_flat_snapshot(const std::string& path, std::uint64_t count, ForEach&& for_each) {
+  namespace fmt = flat_snapshot_format;
+  const fmt::header h = fmt::layout<Key, T>(count);
+  const std::string tmp = path + ".tmp";
+  std::FILE* f = std::fopen(tmp.c_str(), "wb");
+  if (!f) fmt::fail("cannot create", tmp);
+  std::uint64_t pos = 0;
+  auto put = [&](const void* p, std::size_t n) {
+    if (std::fwrite(p, 1, n, f) != n) fmt::fail("write failed on", tmp);
+    pos += n;
+  };
+  auto pad_to = [&](std::uint64_t off) {
+    static constexpr char zeros[fmt::kAlign] = {};
+    while (pos < off) put(zeros, std::min<std::uint64_t>(off - pos, sizeof zeros));
+  };
+  try {
+    put(&h, sizeof h);
+    pad_to(h.keys_offset);
+    std::vector<Key> index;
+    index.reserve((count + fmt::kFanout - 1) / fmt::kFanout);
+    std::uint64_t n = 0;
+    auto key_pass = [&](const Key& k, const auto&...) {
+      if (n++ % fmt::kFanout == 0) index.push_back(k);
+      put(&k, sizeof k);
+    };
+    for_each(key_pass);
+    if (n != count) throw std::logic_error("write_flat_snapshot: element count differs from count");
+    if constexpr (!std::is_void_v<T>) {
+      pad_to(h.values_offset);
+      for_each([&](const Key&, const T& v) { put(&v, sizeof v); });
+    }
+    pad_to(h.index_offset);
+    if (!index.empty()) put(index.data(), index.size() * sizeof(Key));
+    if (std::fflush(f) != 0 || fsync(fileno(f)) != 0) fmt::fail("cannot flush", tmp);
+  } catch (...) {
+    std::fclose(f);
+    std::remove(tmp.c_str());
+    throw;
+  }
+  if (std::fclose(f) != 0) fmt::fail("cannot close", tmp);
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) fmt::fail("cannot rename to", path);
+}
+
+// Read-only view of a file written by write_flat_snapshot. Lookups binary
+// search the index (small enough to stay cached) and then one block of
+// kFanout keys, touching about two cache lines of the key array. The view
+// is a sized range of (key, value) pairs, so avl_tree::build_from_sorted
+// and friends accept it directly.
+template <class Key, class T = void, class Compare = std::less<Key>>
+requires flat_storable<Key, T>
+class flat_snapshot {
+  static constexpr bool is_set = std::is_void_v<T>;
+  using value_array = std::conditional_t<is_set, std::byte, T>;
+
+  void* base_ = nullptr;
+  std::size_t length_ = 0;
+  const Key* keys_ = nullptr;
+  const value_array* values_ = nullptr;
+  const Key* index_ = nullptr;
+  std::size_t size_ = 0;
+  std::size_t index_size_ = 0;
+  [[no_unique_address]] Compare comp_{};
+
+  void unmap() noexcept {
+    if (base_) munmap(base_, length_);
+    base_ = nullptr;
+  }
+
+public:
+  // Maps yield (key, value) pairs by value; both are trivially copyable.
+  using reference = std::conditional_t<is_set, const Key&, std::pair<Key, value_array>>;
+
+  class iterator {
+    const flat_snapshot* s_ = nullptr;
+    std::size_t i_ = 0;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::remove_cvref_t<reference>;
+    using difference_type = std::ptrdiff_t;
+
+    iterator() = default;
+    iterator(const flat_snapshot* s, std::size_t i) noexcept : s_(s), i_(i) {}
+    reference operator*() const noexcept { return (*s_)[i_]; }
+    iterator& operator++() noexcept { ++i_; return *this; }
+    iterator operator++(int) noexcept { auto t = *this; ++i_; return t; }
+    bool operator==(const iterator& o) const noexcept { return i_ == o.i_; }
+  };
+
+  explicit flat_snapshot(const std::string& path, Compare comp = {}) : comp_(std::move(comp)) {
+    namespace fmt = flat_snapshot_format;
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) fmt::fail("cannot open", path);
+    struct stat st{};
+    if (fstat(fd, &st) != 0) { ::close(fd); fmt::fail("cannot stat", path); }
+    length_ = static_cast<std::size_t>(st.st_size);
+    if (length_ < sizeof(fmt::header)) { ::close(fd); throw std::runtime_error("flat_snapshot: '" + path + "' is truncated"); }
+    base_ = mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base_ == MAP_FAILED) { base_ = nullptr; fmt::fail("cannot map", path); }
+
+    fmt::header h;
+    std::memcpy(&h, base_, sizeof h);
+    const fmt::header want = fmt::layout<Key, T>(h.count);
+    if (!std::equal(std::begin(h.magic), std::end(h.magic), fmt::kMagic) || h.byte_order != fmt::kByteOrder ||
+        h.fanout != want.fanout || h.key_size != want.key_size || h.key_align != want.key_align ||
+        h.value_size != want.value_size || h.value_align != want.value_align ||
+        h.keys_offset != want.keys_offset || h.values_offset != want.values_offset ||
+        h.index_offset != want.index_offset || h.file_size != want.file_size || h.file_size > length_) {
+      unmap();
+      throw std::runtime_error("flat_snapshot: '" + path + "' is not a snapshot of this key/value type");
+    }
+    const auto* bytes = static_cast<const unsigned char*>(base_);
+    keys_ = reinterpret_cast<const Key*>(bytes + h.keys_offset);
+    values_ = reinterpret_cast<const value_array*>(bytes + h.values_offset);
+    index_ = reinterpret_cast<const Key*>(bytes + h.index_offset);
+    size_ = h.count;
+    index_size_ = (h.count + fmt::kFanout - 1) / fmt::kFanout;
+    madvise(base_, length_, MADV_RANDOM);
+    madvise(const_cast<Key*>(index_), index_size_ * sizeof(Key), MADV_WILLNEED);
+  }
+
+  flat_snapshot(flat_snapshot&& o) noexcept
+    : base_(std::exchange(o.base_, nullptr)), length_(o.length_), keys_(o.keys_), values_(o.values_),
+      index_(o.index_), size_(std::exchange(o.size_, 0)), index_size_(std::exchange(o.index_size_, 0)),
+      comp_(std::move(o.comp_)) {}
+  flat_snapshot& operator=(flat_snapshot&& o) noexcept {
+    if (this != &o) {
+      unmap();
+      base_ = std::exchange(o.base_, nullptr);
+      length_ = o.length_;
+      keys_ = o.keys_;
+      values_ = o.values_;
+      index_ = o.index_;
+      size_ = std::exchange(o.size_, 0);
+      index_size_ = std::exchange(o.index_size_, 0);
+      comp_ = std::move(o.comp_);
+    }
+    return *this;
+  }
+  flat_snapshot(const flat_snapshot&) = delete;
+  flat_snapshot& operator=(const flat_snapshot&) = delete;
+  ~flat_snapshot() { unmap(); }
+
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+  [[nodiscard]] std::span<const Key> keys() const noexcept { return {keys_, size_}; }
+  [[nodiscard]] std::span<const T> values() const noexcept requires (!is_set) { return {values_, size_}; }
+
+  [[nodiscard]] reference operator[](std::size_t i) const noexcept {
+    if constexpr (is_set) return keys_[i];
+    else return {keys_[i], values_[i]};
+  }
+
+  // Position of the first key not less than key, size() if there is none.
+  [[nodiscard]] std::size_t lower_bound(const Key& key) const noexcept {
+    constexpr std::size_t fanout = flat_snapshot_format::kFanout;
+    const std::size_t j = std::lower_bound(index_, index_ + index_size_, key, comp_) - index_;
+    if (j == 0) return 0;
+    const std::size_t lo = (j - 1) * fanout + 1, hi = std::min(j * fanout, size_);
+    return std::lower_bound(keys_ + lo, keys_ + hi, key, comp_) - keys_;
+  }
+
+  [[nodiscard]] bool contains(const Key& key) const noexcept {
+    const std::size_t i = lower_bound(key);
+    return i < size_ && !comp_(key, keys_[i]);
+  }
+
+  [[nodiscard]] const T* find(const Key& key) const noexcept requires (!is_set) {
+    const std::size_t i = lower_bound(key);
+    return i < size_ && !comp_(key, keys_[i]) ? values_ + i : nullptr;
+  }
+
+  template <class F>
+  void for_each_inorder(F f) const {
+    for (std::size_t i = 0; i < size_; ++i) {
+      if constexpr (is_set) f(keys_[i]);
+      else f(keys_[i], values_[i]);
+    }
+  }
+
+  [[nodiscard]] iterator begin() const noexcept { return {this, 0}; }
+  [[nodiscard]] iterator end() const noexcept { return {this, size_}; }
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+// Operation counters for the containers, compiled in only when DSA_STATS is
+// defined (CMake: -DDSA_STATS=ON). Without it every hook is an empty inline
+// function, the counter member is an empty [[no_unique_address]] object and
+// stats() reports zeros.
+//
+// Counters are relaxed atomics, so concurrent const lookups (e.g. avl_tree's
+// parallel set operations) count exactly without a data race; get() taken
+// while other threads still run may mix values from different moments.
+struct container_stats {
+  std::uint64_t comparisons = 0;
+  std::uint64_t node_visits = 0;
+  std::uint64_t rotations = 0;
+  std::uint64_t sift_steps = 0;
+  std::uint64_t allocations = 0;
+  std::uint64_t max_depth = 0;
+
+  friend std::ostream& operator<<(std::ostream& os, const container_stats& s) {
+    return os << "{\"comparisons\": " << s.comparisons << ", \"node_visits\": " << s.node_visits
+              << ", \"rotations\": " << s.rotations << ", \"sift_steps\": " << s.sift_steps
+              << ", \"allocations\": " << s.allocations << ", \"max_depth\": " << s.max_depth << '}';
+  }
+};
+
+#ifdef DSA_STATS
+class stats_counter {
+  using counter = std::atomic<std::uint64_t>;
+  mutable counter comparisons_{0}, node_visits_{0}, rotations_{0}, sift_steps_{0}, allocations_{0}, max_depth_{0};
+
+  static void bump(counter& c) noexcept { c.fetch_add(1, std::memory_order_relaxed); }
+  void assign(const container_stats& s) noexcept {
+    comparisons_.store(s.comparisons, std::memory_order_relaxed);
+    node_visits_.store(s.node_visits, std::memory_order_relaxed);
+    rotations_.store(s.rotations, std::memory_order_relaxed);
+    sift_steps_.store(s.sift_steps, std::memory_order_relaxed);
+    allocations_.store(s.allocations, std::memory_order_relaxed);
+    max_depth_.store(s.max_depth, std::memory_order_relaxed);
+  }
+
+public:
+  static constexpr bool enabled = true;
+  stats_counter() = default;
+  stats_counter(const stats_counter& o) noexcept { assign(o.get()); }
+  stats_counter& operator=(const stats_counter& o) noexcept {
+    assign(o.get());
+    return *this;
+  }
+
+  void compare() const noexcept { bump(comparisons_); }
+  void visit() const noexcept { bump(node_visits_); }
+  void rotate() const noexcept { bump(rotations_); }
+  void sift() const noexcept { bump(sift_steps_); }
+  void allocate() const noexcept { bump(allocations_); }
+  void depth(std::uint64_t d) const noexcept {
+    std::uint64_t cur = max_depth_.load(std::memory_order_relaxed);
+    while (cur < d && !max_depth_.compare_exchange_weak(cur, d, std::memory_order_relaxed)) {}
+  }
+  [[nodiscard]] container_stats get() const noexcept {
+    return {comparisons_.load(std::memory_order_relaxed), node_visits_.load(std::memory_order_relaxed),
+            rotations_.load(std::memory_order_relaxed),   sift_steps_.load(std::memory_order_relaxed),
+            allocations_.load(std::memory_order_relaxed), max_depth_.load(std::memory_order_relaxed)};
+  }
+  void reset() noexcept { assign({}); }
+};
+#else
+class stats_counter {
+public:
+  static constexpr bool enabled = false;
+  void compare() const noexcept {}
+  void visit() const noexcept {}
+  void rotate() const noexcept {}
+  void sift() const noexcept {}
+  void allocate() const noexcept {}
+  void depth(std::uint64_t) const noexcept {}
+  [[nodiscard]] container_stats get() const noexcept { return {}; }
+  void reset() noexcept {}
+};
+#endif
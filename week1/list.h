@@ -147,7 +147,7 @@ class LinkedStack {
         head_=n; 
       }
 
-      size_=0; 
+      sz_=0; 
     }
 };
 
@@ -16,14 +16,17 @@ void quicksort(I first, I last, Comp comp = {}, Proj proj = {}) {
       if (!(left < right)) break;
       std::iter_swap(left++, right--);
     }
-    I mid = right + 1;
+    // When the scans meet on one element it equals the pivot and is already
+    // in place; leaving it out keeps both halves strictly smaller.
+    I lo_end = left == right ? left : right + 1;
+    I hi_begin = left == right ? left + 1 : left;
 
-    if (mid - first < last - mid) {
-      quicksort(first, mid, comp, proj);
-      first = mid;
+    if (lo_end - first < last - hi_begin) {
+      quicksort(first, lo_end, comp, proj);
+      first = hi_begin;
     } else {
-      quicksort(mid, last, comp, proj);
-      last = mid;
+      quicksort(hi_begin, last, comp, proj);
+      last = lo_end;
     }
   }
 }
@@ -0,0 +1,306 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "../week6/heap.cpp"
+
+// Search over implicit graphs. A problem is a start state, a goal test and
+// a successor generator: successors(state, emit) calls emit(next, action)
+// for every move, or emit(next, action, cost) when moves are weighted (the
+// cost defaults to 1). Nothing about the graph is stored up front.
+//
+//   bfs       fewest moves; layer by layer, optionally in parallel
+//   astar     cheapest path under an admissible heuristic, open list on Heap
+//   ida_star  the same by iterative deepening, memory linear in the depth
+namespace graph_search {
+
+template <class State, class Action, class Cost = std::size_t>
+struct search_path {
+  struct step {
+    Action action;
+    State state;  // after the action
+  };
+  std::vector<step> steps;
+  Cost cost{};
+  std::size_t expanded = 0;  // states whose successors were generated
+};
+
+// Visited set for a space numbered 0..size-1 by index(state): one bit per
+// state. insert_shared may be called from several threads at once. Both
+// throw std::out_of_range for an index outside the space.
+template <class Index>
+class dense_visited {
+  std::vector<std::uint64_t> bits_;
+  std::uint64_t size_;
+  Index index_;
+
+  template <class State>
+  std::uint64_t checked_index(const State& s) const {
+    const std::uint64_t i = index_(s);
+    if (i >= size_) throw std::out_of_range("dense_visited: state index outside the space");
+    return i;
+  }
+
+public:
+  dense_visited(std::uint64_t size, Index index) : bits_((size + 63) / 64), size_(size), index_(std::move(index)) {}
+
+  template <class State>
+  bool insert(const State& s) {
+    const std::uint64_t i = checked_index(s), bit = std::uint64_t{1} << (i & 63);
+    if (bits_[i >> 6] & bit) return false;
+    bits_[i >> 6] |= bit;
+    return true;
+  }
+
+  template <class State>
+  bool insert_shared(const State& s) {
+    const std::uint64_t i = checked_index(s), bit = std::uint64_t{1} << (i & 63);
+    std::atomic_ref<std::uint64_t> word(bits_[i >> 6]);
+    return !(word.load(std::memory_order_relaxed) & bit) && !(word.fetch_or(bit, std::memory_order_relaxed) & bit);
+  }
+
+  [[nodiscard]] std::size_t bytes() const noexcept { return bits_.size() * sizeof(std::uint64_t); }
+};
+
+// Visited set for sparse or unbounded spaces, split into independently
+// locked shards for insert_shared.
+template <class State, class Hash = std::hash<State>, class Eq = std::equal_to<State>>
+class hashed_visited {
+  static constexpr std::size_t kShards = 64;
+  struct alignas(64) shard {
+    std::mutex m;
+    std::unordered_set<State, Hash, Eq> set;
+  };
+  std::unique_ptr<shard[]> shards_ = std::make_unique<shard[]>(kShards);
+  [[no_unique_address]] Hash hash_{};
+
+  shard& of(const State& s) { return shards_[hash_(s) % kShards]; }
+
+public:
+  bool insert(const State& s) { return of(s).set.insert(s).second; }
+
+  bool insert_shared(const State& s) {
+    shard& sh = of(s);
+    std::lock_guard lock(sh.m);
+    return sh.set.insert(s).second;
+  }
+
+  [[nodiscard]] std::size_t size() const {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < kShards; ++i) n += shards_[i].set.size();
+    return n;
+  }
+};
+
+struct bfs_options {
+  unsigned threads = 1;                  // 0: one per core
+  std::size_t parallel_layer = 1 << 14;  // smaller layers are expanded on one thread
+};
+
+// Breadth-first search from start to the nearest goal. States are recorded
+// once, when first generated, together with the move that reached them;
+// each layer is the run of records appended while expanding the previous
+// one. With several threads a large layer is cut into one slice per thread
+// and the slices are appended in order, so successors must be safe to call
+// concurrently and Visited must provide insert_shared.
+template <class Action, class State, class Successors, class Goal, class Visited>
+requires std::copyable<State> && std::default_initializable<Action> && std::predicate<Goal&, const State&>
+std::optional<search_path<State, Action>> bfs(const State& start, Successors&& successors, Goal&& is_goal,
+                                              Visited& visited, bfs_options opt = {}) {
+  using index = std::uint32_t;
+  static constexpr index none = std::numeric_limits<index>::max();
+  struct record {
+    State state;
+    index parent;
+    Action action;
+  };
+
+  std::vector<record> seen;
+  std::size_t expanded = 0;
+  auto path_to = [&](std::size_t goal) {
+    search_path<State, Action> p;
+    for (std::size_t u = goal; seen[u].parent != none; u = seen[u].parent) p.steps.push_back({seen[u].action, seen[u].state});
+    std::reverse(p.steps.begin(), p.steps.end());
+    p.cost = p.steps.size();
+    p.expanded = expanded;
+    return p;
+  };
+  auto append = [&](State&& s, std::size_t parent, const Action& a) {
+    if (seen.size() == none) throw std::length_error("graph_search::bfs: more than 2^32 - 1 states");
+    seen.push_back({std::move(s), static_cast<index>(parent), a});
+  };
+
+  visited.insert(start);
+  seen.push_back({start, none, Action{}});
+  if (is_goal(start)) return path_to(0);
+
+  const unsigned threads = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+  for (std::size_t lo = 0, hi; lo < seen.size(); lo = hi) {
+    hi = seen.size();
+    std::optional<std::size_t> goal;
+    if (threads > 1 && hi - lo >= opt.parallel_layer) {
+      std::vector<std::vector<record>> slices(threads);
+      {
+        std::vector<std::jthread> pool;
+        for (unsigned t = 0; t < threads; ++t) {
+          pool.emplace_back([&, t] {
+            const std::size_t b = lo + (hi - lo) * t / threads, e = lo + (hi - lo) * (t + 1) / threads;
+            for (std::size_t u = b; u < e; ++u)
+              successors(std::as_const(seen[u].state), [&](const State& next, const Action& a, auto&&...) {
+                if (visited.insert_shared(next)) slices[t].push_back({next, static_cast<index>(u), a});
+              });
+          });
+        }
+      }
+      expanded += hi - lo;
+      for (auto& slice : slices) {
+        for (auto& r : slice) {
+          append(std::move(r.state), r.parent, r.action);
+          if (!goal && is_goal(seen.back().state)) goal = seen.size() - 1;
+        }
+      }
+    } else {
+      for (std::size_t u = lo; u < hi && !goal; ++u) {
+        const State s = seen[u].state;  // seen may reallocate while s is expanded
+        ++expanded;
+        successors(s, [&](const State& next, const Action& a, auto&&...) {
+          if (goal || !visited.insert(next)) return;
+          append(State(next), u, a);
+          if (is_goal(next)) goal = seen.size() - 1;
+        });
+      }
+    }
+    if (goal) return path_to(*goal);
+  }
+  return std::nullopt;
+}
+
+// A* from start to the cheapest goal. h must never overestimate the
+// remaining cost; if it is not also consistent, states are reopened when a
+// cheaper path to them turns up, so the result stays optimal. The open list
+// is a Heap with lazy deletion: a state improved after being queued is
+// queued again and the outdated entry is skipped when it surfaces.
+template <class Action, class State, class Successors, class Goal, class Heuristic,
+          class Hash = std::hash<State>, class Eq = std::equal_to<State>>
+requires std::copyable<State> && std::default_initializable<Action> && std::predicate<Goal&, const State&> &&
+         std::invocable<Heuristic&, const State&>
+auto astar(const State& start, Successors&& successors, Goal&& is_goal, Heuristic&& h)
+    -> std::optional<search_path<State, Action, std::invoke_result_t<Heuristic&, const State&>>> {
+  using Cost = std::invoke_result_t<Heuristic&, const State&>;
+  using index = std::uint32_t;
+  static constexpr index none = std::numeric_limits<index>::max();
+  struct record {
+    State state;
+    index parent;
+    Action action;
+    Cost g;
+  };
+  struct entry {
+    Cost f, g;
+    index id;
+  };
+  // Heap keeps the greatest entry on top: order by f descending, and among
+  // equal f prefer the deeper entry, which is closer to a goal.
+  struct later {
+    bool operator()(const entry& a, const entry& b) const noexcept { return a.f > b.f || (a.f == b.f && a.g < b.g); }
+  };
+
+  std::vector<record> nodes;
+  std::unordered_map<State, index, Hash, Eq> id_of;
+  Heap<entry, later> open;
+  std::size_t expanded = 0;
+
+  nodes.push_back({start, none, Action{}, Cost{}});
+  id_of.emplace(start, 0);
+  open.push({h(start), Cost{}, 0});
+  while (!open.empty()) {
+    const entry e = open.pop();
+    if (e.g != nodes[e.id].g) continue;
+    if (is_goal(nodes[e.id].state)) {
+      search_path<State, Action, Cost> p;
+      for (index u = e.id; nodes[u].parent != none; u = nodes[u].parent) p.steps.push_back({nodes[u].action, nodes[u].state});
+      std::reverse(p.steps.begin(), p.steps.end());
+      p.cost = e.g;
+      p.expanded = expanded;
+      return p;
+    }
+    ++expanded;
+    const State s = nodes[e.id].state;
+    successors(s, [&](const State& next, const Action& a, Cost c = Cost{1}) {
+      const Cost g = e.g + c;
+      // Checked before try_emplace, which would otherwise map next to none.
+      if (nodes.size() == none) throw std::length_error("graph_search::astar: more than 2^32 - 1 states");
+      auto [it, fresh] = id_of.try_emplace(next, static_cast<index>(nodes.size()));
+      if (fresh) {
+        nodes.push_back({next, e.id, a, g});
+      } else if (g < nodes[it->second].g) {
+        nodes[it->second].parent = e.id;
+        nodes[it->second].action = a;
+        nodes[it->second].g = g;
+      } else {
+        return;
+      }
+      open.push({g + h(next), g, it->second});
+    });
+  }
+  return std::nullopt;
+}
+
+// IDA*: depth-first passes bounded by f = g + h, each pass raising the bound
+// to the smallest f that exceeded it. Keeps only the current path, checked
+// to avoid cycles, so memory stays linear in the solution depth at the
+// price of re-expanding states; suits deep spaces with a strong h and few
+// transpositions. Gives up once the bound would pass max_cost.
+template <class Action, class State, class Successors, class Goal, class Heuristic>
+requires std::copyable<State> && std::equality_comparable<State> && std::predicate<Goal&, const State&> &&
+         std::invocable<Heuristic&, const State&>
+auto ida_star(const State& start, Successors&& successors, Goal&& is_goal, Heuristic&& h,
+              std::invoke_result_t<Heuristic&, const State&> max_cost =
+                  std::numeric_limits<std::invoke_result_t<Heuristic&, const State&>>::max())
+    -> std::optional<search_path<State, Action, std::invoke_result_t<Heuristic&, const State&>>> {
+  using Cost = std::invoke_result_t<Heuristic&, const State&>;
+  search_path<State, Action, Cost> p;
+  std::vector<State> on_path{start};
+  bool found = false;
+  Cost bound = h(start), next_bound;
+
+  auto dfs = [&](auto& self, const State& s, Cost g) -> void {
+    const Cost f = g + h(s);
+    if (f > bound) { next_bound = std::min(next_bound, f); return; }
+    if (is_goal(s)) { found = true; p.cost = g; return; }
+    ++p.expanded;
+    successors(s, [&](const State& next, const Action& a, Cost c = Cost{1}) {
+      if (found || std::find(on_path.begin(), on_path.end(), next) != on_path.end()) return;
+      on_path.push_back(next);
+      p.steps.push_back({a, next});
+      self(self, next, g + c);
+      if (found) return;
+      on_path.pop_back();
+      p.steps.pop_back();
+    });
+  };
+
+  while (bound <= max_cost) {
+    next_bound = std::numeric_limits<Cost>::max();
+    dfs(dfs, start, Cost{});
+    if (found) return p;
+    if (next_bound == std::numeric_limits<Cost>::max()) break;
+    bound = next_bound;
+  }
+  return std::nullopt;
+}
+
+}  // namespace graph_search
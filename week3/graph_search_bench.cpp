@@ -0,0 +1,78 @@
+#include <bits/stdc++.h>
+#include "graph_search.cpp"
+
+using u64 = unsigned long long;
+
+template <class F>
+double millis(F&& f) {
+  const auto t0 = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Four-peg Tower of Hanoi, two bits of peg per disk: every one of the 4^n
+// placements is reachable, which makes the space a good stress test.
+struct Towers {
+  unsigned n;
+  static constexpr unsigned pegs = 4;
+
+  unsigned peg_of(u64 s, unsigned d) const { return (s >> (2 * (d - 1))) & 3; }
+  u64 goal() const { return n ? (~0ULL >> (64 - 2 * n)) : 0; }
+
+  template <class Emit>
+  void operator()(u64 s, Emit&& emit) const {
+    unsigned top[pegs] = {};
+    for (unsigned d = n; d >= 1; --d) top[peg_of(s, d)] = d;
+    for (unsigned from = 0; from < pegs; ++from) {
+      const unsigned d = top[from];
+      if (!d) continue;
+      for (unsigned to = 0; to < pegs; ++to)
+        if (to != from && (!top[to] || top[to] > d)) emit((s & ~(3ULL << 2 * (d - 1))) | (u64(to) << 2 * (d - 1)), char('A' + to));
+    }
+  }
+};
+
+int main(int argc, char** argv) {
+  std::ios::sync_with_stdio(false);
+  std::cin.tie(nullptr);
+  std::cout.tie(nullptr);
+
+  const unsigned n = argc > 1 ? std::stoul(argv[1]) : 10;
+  const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  const Towers towers{n};
+  const u64 goal = towers.goal();
+  auto reached = [&](u64 s) { return s == goal; };
+  auto identity = [](u64 s) { return s; };
+  std::cout << "4-peg Hanoi, n = " << n << " (" << (1ULL << 2 * n) << " states)\n" << std::fixed << std::setprecision(1);
+
+  std::size_t moves = 0;
+  graph_search::hashed_visited<u64> hashed;
+  const double t_hashed = millis([&] { moves = graph_search::bfs<char>(u64{0}, towers, reached, hashed)->steps.size(); });
+  std::cout << "bfs, hashed visited:      " << t_hashed << " ms  (" << moves << " moves)\n";
+
+  graph_search::dense_visited dense(1ULL << 2 * n, identity);
+  const double t_dense = millis([&] { moves = graph_search::bfs<char>(u64{0}, towers, reached, dense)->steps.size(); });
+  std::cout << "bfs, dense visited:       " << t_dense << " ms  (" << dense.bytes() / 1024 << " KiB of bits)\n";
+
+  graph_search::dense_visited shared(1ULL << 2 * n, identity);
+  const double t_par = millis([&] {
+    moves = graph_search::bfs<char>(u64{0}, towers, reached, shared, {.threads = threads})->steps.size();
+  });
+  std::cout << "bfs, dense, " << threads << " threads:   " << t_par << " ms\n";
+
+  std::size_t expanded = 0;
+  const double t_astar = millis([&] {
+    auto h = [&](u64 s) {
+      unsigned m = n;
+      while (m >= 1 && towers.peg_of(s, m) == 3) --m;
+      unsigned b = m ? 1 : 0;
+      for (unsigned d = 1; d < m; ++d) b += towers.peg_of(s, d) == 3 ? 2 : 1;
+      return b;
+    };
+    const auto p = graph_search::astar<char>(u64{0}, towers, reached, h);
+    moves = p->steps.size();
+    expanded = p->expanded;
+  });
+  std::cout << "astar:                    " << t_astar << " ms  (" << expanded << " states expanded, " << moves << " moves)\n";
+  return 0;
+}
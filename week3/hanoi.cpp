@@ -1,4 +1,5 @@
 #include <bits/stdc++.h>
+#include "graph_search.cpp"
 
 using u64 = unsigned long long;
 using i64 = long long;
@@ -22,14 +23,76 @@ void hanoi_iter_gray(unsigned n, std::array<char, 3> names = {'A','B','C'}) {
   }
 }
 
+struct Move { unsigned disk; unsigned from, to; };
+
+// Fewest moves for n disks on `pegs` pegs, from the first peg to the last,
+// found by A*; with four or more pegs there is no simple move pattern to
+// follow. A state packs each disk's peg into bits_per_disk bits. The
+// heuristic is a per-disk lower bound: the largest disk m off the target
+// needs one move; each smaller disk needs one, or two if it now sits on the
+// target, since it must clear the way for m and come back.
+std::optional<std::vector<Move>> hanoi_search(unsigned n, unsigned pegs) {
+  const unsigned bits_per_disk = std::bit_width(pegs - 1);
+  // A* keeps a record for every state it reaches; past pegs^n = 2^22 the
+  // weak bound lets it reach most of them.
+  if (pegs < 3 || pegs > 16 || std::pow(double(pegs), n) > double(1 << 22)) return std::nullopt;
+  const u64 mask = (1ULL << bits_per_disk) - 1;
+  const unsigned target = pegs - 1;
+  auto peg_of = [=](u64 s, unsigned d) { return static_cast<unsigned>((s >> ((d - 1) * bits_per_disk)) & mask); };
+
+  u64 goal = 0;
+  for (unsigned d = 1; d <= n; ++d) goal |= u64(target) << ((d - 1) * bits_per_disk);
+
+  auto moves = [&](u64 s, auto&& emit) {
+    std::vector<unsigned> top(pegs, 0);
+    for (unsigned d = n; d >= 1; --d) top[peg_of(s, d)] = d;
+    for (unsigned from = 0; from < pegs; ++from) {
+      const unsigned d = top[from];
+      if (!d) continue;
+      for (unsigned to = 0; to < pegs; ++to) {
+        if (to == from || (top[to] && top[to] < d)) continue;
+        const unsigned shift = (d - 1) * bits_per_disk;
+        emit((s & ~(mask << shift)) | (u64(to) << shift), Move{d, from, to});
+      }
+    }
+  };
+  auto lower_bound = [&](u64 s) {
+    unsigned m = n;
+    while (m >= 1 && peg_of(s, m) == target) --m;
+    if (!m) return 0u;
+    unsigned h = 1;
+    for (unsigned d = 1; d < m; ++d) h += peg_of(s, d) == target ? 2 : 1;
+    return h;
+  };
+
+  auto found = graph_search::astar<Move>(u64{0}, moves, [&](u64 s) { return s == goal; }, lower_bound);
+  if (!found) return std::nullopt;
+  std::vector<Move> plan;
+  for (const auto& step : found->steps) plan.push_back(step.action);
+  return plan;
+}
+
 int main() {
   std::ios::sync_with_stdio(false);
   std::cin.tie(nullptr);
   std::cout.tie(nullptr);
 
-  unsigned n;
+  unsigned n, pegs = 3;
   if (!(std::cin >> n)) return 0;
-  hanoi_iter_gray(n, {'A','B','C'});
+  std::cin >> pegs;
+  if (pegs == 3) {
+    hanoi_iter_gray(n, {'A','B','C'});
+    return 0;
+  }
+
+  auto plan = hanoi_search(n, pegs);
+  if (!plan) {
+    std::cout << "unsupported: need 3 to 16 pegs and pegs^n <= 2^22\n";
+    return 0;
+  }
+  std::cout << "total moves = " << plan->size() << '\n';
+  for (const auto& m : *plan)
+    std::cout << "move disk " << m.disk << ": " << char('A' + m.from) << " -> " << char('A' + m.to) << '\n';
   
   return 0;
 }
@@ -1,4 +1,5 @@
 #include <bits/stdc++.h>
+#include "graph_search.cpp"
 
 using u64 = unsigned long long;
 using i64 = long long;
@@ -13,49 +14,31 @@ std::optional <Plan> solve(int cap_a, int cap_b, int target) {
   int g = std::gcd(cap_a, cap_b);
   if (g == 0 || target % g != 0) return std::nullopt;
 
-  const int W = cap_b + 1, N = (cap_a + 1) * (cap_b + 1);
-  auto id = [&](int x, int y){ return x * W + y; };
-  auto from = [&](int u) -> State { return {u / W, u % W}; };
+  const u64 W = cap_b + 1, N = u64(cap_a + 1) * W;
+  graph_search::dense_visited visited(N, [&](const State& s) { return s.a * W + s.b; });
 
-  std::vector<char> vis(N, 0);
-  std::vector<int> prev(N, -1);
-  std::vector<std::string_view> how(N);
-  std::queue<int> q;
-
-  int start = id(0, 0);
-  vis[start] = 1; q.push(start);
-
-  int goal = -1;
-  while (!q.empty()) {
-    int u = q.front(); q.pop();
-    auto [x, y] = from(u);
-    if (x == target || y == target) { goal = u; break; }
-
-    auto push = [&](int nx, int ny, std::string_view op) {
-      int v = id(nx, ny);
-      if (vis[v]) return;
-      vis[v] = 1; prev[v] = u; how[v] = op; q.push(v);
-    };
-
-    if (x < cap_a) push(cap_a, y, "fill A");
-    if (y < cap_b) push(x, cap_b, "fill B");
-    if (x > 0)     push(0, y,     "empty A");
-    if (y > 0)     push(x, 0,     "empty B");
+  auto moves = [&](const State& s, auto&& emit) {
+    auto [x, y] = s;
+    if (x < cap_a) emit(State{cap_a, y}, "fill A");
+    if (y < cap_b) emit(State{x, cap_b}, "fill B");
+    if (x > 0)     emit(State{0, y},     "empty A");
+    if (y > 0)     emit(State{x, 0},     "empty B");
     if (x > 0 && y < cap_b) {
       int pour = std::min(x, cap_b - y);
-      push(x - pour, y + pour, "pour A->B");
+      emit(State{x - pour, y + pour}, "pour A->B");
     }
     if (y > 0 && x < cap_a) {
       int pour = std::min(y, cap_a - x);
-      push(x + pour, y - pour, "pour B->A");
+      emit(State{x + pour, y - pour}, "pour B->A");
     }
-  }
+  };
+  auto reached = [&](const State& s) { return s.a == target || s.b == target; };
 
-  if (goal < 0) return std::nullopt;
+  auto found = graph_search::bfs<std::string_view>(State{0, 0}, moves, reached, visited);
+  if (!found) return std::nullopt;
 
   Plan path;
-  for (int u = goal; u != start; u = prev[u]) path.push_back({how[u], from(u)});
-  std::reverse(path.begin(), path.end());
+  for (const auto& step : found->steps) path.push_back({step.action, step.state});
   return path;
 }
 
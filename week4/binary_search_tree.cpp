@@ -1,4 +1,7 @@
+#pragma once
 #include <bits/stdc++.h>
+#include "../common/flat_snapshot.h"
+#include "../common/stats.h"
 
 template <class T, class Comp = std::less<T>>
 class BinaryTree {
@@ -14,27 +17,72 @@ private:
   std::unique_ptr<Node> root_;
   std::size_t size_ = 0;
   Comp comp_{};
+  [[no_unique_address]] stats_counter stats_{};
+
+  bool less(const T& a, const T& b) const {
+    stats_.compare();
+    return comp_(a, b);
+  }
 
 public:
   BinaryTree() = default;
+  BinaryTree(BinaryTree&&) noexcept = default;
+  BinaryTree& operator=(BinaryTree&&) noexcept = default;
   ~BinaryTree() = default;
 
+  // Perfectly balanced tree from values in strictly increasing order, O(n).
+  template <std::ranges::input_range R>
+  requires std::constructible_from<T, std::ranges::range_reference_t<R>>
+  [[nodiscard]] static BinaryTree build_from_sorted(R&& r) {
+    BinaryTree t;
+    std::vector<T> a;
+    if constexpr (std::ranges::sized_range<R>) a.reserve(std::ranges::size(r));
+    for (auto&& v : r) {
+      a.emplace_back(std::forward<decltype(v)>(v));
+      if (a.size() > 1 && !t.comp_(a[a.size() - 2], a.back()))
+        throw std::invalid_argument("BinaryTree::build_from_sorted: values not strictly increasing");
+    }
+    t.root_ = link_sorted(a, 0, a.size());
+    t.size_ = a.size();
+    return t;
+  }
+
+  // Writes the values in order as a flat snapshot (common/flat_snapshot.h);
+  // flat_snapshot<T, void, Comp> queries the file in place and load()
+  // rebuilds a balanced tree from it.
+  void save(const std::string& path) const requires flat_storable<T, void> {
+    write_flat_snapshot<T, void>(path, size_, [this](auto&& emit) { inorder(emit); });
+  }
+
+  [[nodiscard]] static BinaryTree load(const std::string& path) requires flat_storable<T, void> {
+    return build_from_sorted(flat_snapshot<T, void, Comp>(path).keys());
+  }
+
   [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
   [[nodiscard]] std::size_t size() const noexcept { return size_; }
 
-  void insert(const T& v) { insert_impl(root_, v); }
-  void insert(T&& v) { insert_impl(root_, std::move(v)); }
+  void insert(const T& v) { insert_impl(root_, v, 1); }
+  void insert(T&& v) { insert_impl(root_, std::move(v), 1); }
 
   [[nodiscard]] bool contains(const T& x) const {
     const Node* cur = root_.get();
+    std::uint64_t depth = 0;
     while (cur) {
-      if (comp_(x, cur->value)) cur = cur->left.get();
-      else if (comp_(cur->value, x)) cur = cur->right.get();
+      stats_.visit();
+      stats_.depth(++depth);
+      if (less(x, cur->value)) cur = cur->left.get();
+      else if (less(cur->value, x)) cur = cur->right.get();
       else return true;
     }
     return false;
   }
 
+  // Comparisons, nodes visited, allocations and the deepest node reached by
+  // insert or contains; all zero unless built with DSA_STATS. A max_depth
+  // far above log2(size()) means the input arrived (nearly) sorted.
+  [[nodiscard]] container_stats stats() const noexcept { return stats_.get(); }
+  void reset_stats() noexcept { stats_.reset(); }
+
   [[nodiscard]] int height() const noexcept { return height_impl(root_.get()); }
 
   [[nodiscard]] std::vector<T> preorder() const {
@@ -56,13 +104,24 @@ public:
 
 private:
   template <class U>
-  void insert_impl(std::unique_ptr<Node>& node, U&& v) {
-    if (!node) { node = std::make_unique<Node>(std::forward<U>(v)); ++size_; return; }
-    if (comp_(v, node->value)) insert_impl(node->left, std::forward<U>(v));
-    else if (comp_(node->value, v)) insert_impl(node->right, std::forward<U>(v));
+  void insert_impl(std::unique_ptr<Node>& node, U&& v, std::uint64_t depth) {
+    stats_.depth(depth);
+    if (!node) { node = std::make_unique<Node>(std::forward<U>(v)); stats_.allocate(); ++size_; return; }
+    stats_.visit();
+    if (less(v, node->value)) insert_impl(node->left, std::forward<U>(v), depth + 1);
+    else if (less(node->value, v)) insert_impl(node->right, std::forward<U>(v), depth + 1);
     else { }
   }
 
+  static std::unique_ptr<Node> link_sorted(std::vector<T>& a, std::size_t lo, std::size_t hi) {
+    if (lo == hi) return nullptr;
+    const std::size_t mid = lo + (hi - lo) / 2;
+    auto n = std::make_unique<Node>(std::move(a[mid]));
+    n->left = link_sorted(a, lo, mid);
+    n->right = link_sorted(a, mid + 1, hi);
+    return n;
+  }
+
   static int height_impl(const Node* n) noexcept {
     if (!n) return -1;
     return 1 + std::max(height_impl(n->left.get()), height_impl(n->right.get()));
@@ -109,27 +168,3 @@ private:
     f(n->value);
   }
 };
-
-int main() {
-  std::ios::sync_with_stdio(false);
-  std::cin.tie(nullptr);
-  std::cout.tie(nullptr);
-
-  BinaryTree<int> bt;
-  for (int x : {7, 3, 9, 1, 5, 8, 10, 4, 6}) bt.insert(x);
-
-  std::cout << "size=" << bt.size() << " height=" << bt.height() << "\n";
-
-  auto in = bt.inorder();
-  std::cout << "Inorder: ";
-  for (int x : in) std::cout << x << ' ';
-  std::cout << "\n";
-
-  std::cout << "Preorder (callback): ";
-  bt.preorder([](const int& x){ std::cout << x << ' '; });
-  std::cout << "\n";
-
-  std::cout << std::boolalpha << "contains 5? " << bt.contains(5) << ", contains 42? " << bt.contains(42) << "\n";
-  
-  return 0;
-}
@@ -0,0 +1,34 @@
+#include <bits/stdc++.h>
+#include "binary_search_tree.cpp"
+
+int main() {
+  std::ios::sync_with_stdio(false);
+  std::cin.tie(nullptr);
+  std::cout.tie(nullptr);
+
+  BinaryTree<int> bt;
+  for (int x : {7, 3, 9, 1, 5, 8, 10, 4, 6}) bt.insert(x);
+
+  std::cout << "size=" << bt.size() << " height=" << bt.height() << "\n";
+
+  auto in = bt.inorder();
+  std::cout << "Inorder: ";
+  for (int x : in) std::cout << x << ' ';
+  std::cout << "\n";
+
+  std::cout << "Preorder (callback): ";
+  bt.preorder([](const int& x){ std::cout << x << ' '; });
+  std::cout << "\n";
+
+  std::cout << std::boolalpha << "contains 5? " << bt.contains(5) << ", contains 42? " << bt.contains(42) << "\n";
+
+  const std::string path = (std::filesystem::temp_directory_path() / "binary_search_tree.snap").string();
+  bt.save(path);
+  const flat_snapshot<int> mapped(path);
+  const auto loaded = BinaryTree<int>::load(path);
+  std::cout << "snapshot: " << mapped.size() << " keys, contains 6? " << mapped.contains(6)
+            << ", reloaded height=" << loaded.height() << "\n";
+  std::filesystem::remove(path);
+  
+  return 0;
+}
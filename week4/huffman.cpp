@@ -1,4 +1,8 @@
 #include <bits/stdc++.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 struct Node {
   long long f;
@@ -19,6 +23,8 @@ struct EncodeResult {
   std::array<std::string,256> codebook;
 };
 
+using Histogram = std::array<long long,256>;
+
 static void dfs(const std::shared_ptr<Node>& t, const std::string& pre, std::array<std::string,256>& cb) {
   if (!t) return;
   if (t->ch != -1) { cb[(unsigned)t->ch] = pre.empty() ? "0" : pre; return; }
@@ -26,9 +32,7 @@ static void dfs(const std::shared_ptr<Node>& t, const std::string& pre, std::arr
   dfs(t->r, pre + '1', cb);
 }
 
-static std::shared_ptr<Node> build_tree(const std::vector<std::uint8_t>& data) {
-  std::array<long long,256> f{};
-  for (auto b : data) ++f[b];
+static std::shared_ptr<Node> build_tree(const Histogram& f) {
   std::priority_queue<std::shared_ptr<Node>, std::vector<std::shared_ptr<Node>>, Cmp> pq;
   int kinds = 0;
   for (int c = 0; c < 256; ++c) if (f[c]) { pq.push(std::make_shared<Node>(f[c], c)); ++kinds; }
@@ -45,6 +49,12 @@ static std::shared_ptr<Node> build_tree(const std::vector<std::uint8_t>& data) {
   return pq.top();
 }
 
+static std::shared_ptr<Node> build_tree(const std::vector<std::uint8_t>& data) {
+  Histogram f{};
+  for (auto b : data) ++f[b];
+  return build_tree(f);
+}
+
 EncodeResult huffman_encode(const std::vector<std::uint8_t>& data) {
   EncodeResult r;
   for (auto& s : r.codebook) s.clear();
@@ -56,17 +66,559 @@ EncodeResult huffman_encode(const std::vector<std::uint8_t>& data) {
   return r;
 }
 
-int main() {
-  std::ios::sync_with_stdio(false);
-  std::cin.tie(nullptr);
-  std::cout.tie(nullptr);
+// ---------------------------------------------------------------------------
+// Chunked container: the input is cut into independent chunks, each chunk is
+// split into 4 quarters coded as separate bit streams so the decoder can run
+// 4 independent dependency chains per loop iteration. Chunks are (de)coded in
+// parallel. Codes are canonical and length-limited to kMaxCodeLen bits so a
+// single 2^kMaxCodeLen entry lookup table decodes one symbol per probe.
+//
+//   header : "HUF4" | u32 chunk_size | u64 raw_size | u8 flags | [lengths]
+//   chunk  : u32 raw_size | u32 payload_size | [lengths] | u32 s0,s1,s2 | streams
+//
+// lengths are 256 code lengths packed as nibbles (128 bytes); they sit in the
+// header when kSharedTable is set, otherwise in front of every chunk.
+// ---------------------------------------------------------------------------
+
+constexpr int kMaxCodeLen = 11;
+constexpr int kStreams = 4;
+constexpr std::uint32_t kMagic = 0x34465548; // "HUF4"
+constexpr std::uint8_t kSharedTable = 1;
+
+struct CodeTable {
+  std::array<std::uint8_t,256> len{};
+  std::array<std::uint16_t,256> code{};
+};
+
+struct DecodeEntry { std::uint8_t sym, len; };
+using DecodeTable = std::array<DecodeEntry, 1u << kMaxCodeLen>;
+
+struct ChunkedOptions {
+  std::size_t chunk_size = 256 << 10;
+  unsigned threads = 0;       // 0 = hardware_concurrency
+  bool shared_table = false;  // one table for the whole input instead of one per chunk
+  std::size_t batch_chunks = 0; // chunks in flight when streaming, 0 = 4 per thread
+};
+
+static unsigned resolve_threads(unsigned t) {
+  if (t) return t;
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+template <class F>
+static void parallel_for(std::size_t n, unsigned threads, F&& f) {
+  threads = static_cast<unsigned>(std::min<std::size_t>(resolve_threads(threads), n));
+  if (threads <= 1) { for (std::size_t i = 0; i < n; ++i) f(i); return; }
+  std::atomic<std::size_t> next{0};
+  std::exception_ptr err;
+  std::mutex err_mu;
+  {
+    std::vector<std::jthread> pool;
+    pool.reserve(threads);
+    for (unsigned t = 0; t < threads; ++t) pool.emplace_back([&] {
+      try {
+        for (std::size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < n; ) f(i);
+      } catch (...) {
+        std::lock_guard lk(err_mu);
+        if (!err) err = std::current_exception();
+        next.store(n, std::memory_order_relaxed);
+      }
+    });
+  }
+  if (err) std::rethrow_exception(err);
+}
+
+// Four sub-histograms so that runs of the same byte increment different
+// counters instead of serializing on one load/store-forward chain.
+static Histogram histogram(std::span<const std::uint8_t> in) {
+  std::array<std::array<std::uint32_t,256>,4> h{};
+  const std::uint8_t* p = in.data();
+  std::size_t n = in.size(), i = 0;
+  for (; i + 4 <= n; i += 4) {
+    ++h[0][p[i]]; ++h[1][p[i + 1]]; ++h[2][p[i + 2]]; ++h[3][p[i + 3]];
+  }
+  for (; i < n; ++i) ++h[0][p[i]];
+  Histogram f{};
+  for (int c = 0; c < 256; ++c) f[c] = (long long)h[0][c] + h[1][c] + h[2][c] + h[3][c];
+  return f;
+}
+
+static Histogram parallel_histogram(std::span<const std::uint8_t> in, std::size_t chunk_size, unsigned threads) {
+  const std::size_t chunks = (in.size() + chunk_size - 1) / chunk_size;
+  std::vector<Histogram> part(chunks);
+  parallel_for(chunks, threads, [&](std::size_t i) {
+    part[i] = histogram(in.subspan(i * chunk_size, std::min(chunk_size, in.size() - i * chunk_size)));
+  });
+  Histogram f{};
+  for (auto& h : part) for (int c = 0; c < 256; ++c) f[c] += h[c];
+  return f;
+}
+
+// Huffman code lengths without touching the heap: leaves are sorted by
+// frequency into a flat node array and merged with the two-queue method
+// (leaves and internal nodes are each consumed in nondecreasing order), so
+// the whole build is one sort plus O(k) work on 2k-1 <= 511 nodes.
+static void code_lengths(const Histogram& f, std::array<int,256>& len) {
+  struct FlatNode { long long f; int parent; int sym; };
+  std::array<FlatNode,511> node;
+  int k = 0;
+  for (int c = 0; c < 256; ++c) if (f[c]) node[k++] = {f[c], -1, c};
+  len.fill(0);
+  if (k == 0) return;
+  if (k == 1) { len[node[0].sym] = 1; return; }
+  std::sort(node.begin(), node.begin() + k, [](const FlatNode& a, const FlatNode& b) { return a.f < b.f; });
+
+  int leaf = 0, inner = k, n = k;
+  auto take = [&] {
+    const bool use_leaf = leaf < k && (inner == n || node[leaf].f <= node[inner].f);
+    return use_leaf ? leaf++ : inner++;
+  };
+  while (n < 2 * k - 1) {
+    const int a = take(), b = take();
+    node[n] = {node[a].f + node[b].f, -1, -1};
+    node[a].parent = node[b].parent = n++;
+  }
+
+  // Parents are created after their children, so one backward sweep turns
+  // parent links into depths (stored in place of the frequency).
+  node[n - 1].f = 0;
+  for (int i = n - 2; i >= 0; --i) node[i].f = node[node[i].parent].f + 1;
+  for (int i = 0; i < k; ++i) len[node[i].sym] = static_cast<int>(node[i].f);
+}
+
+static void assign_canonical(CodeTable& t) {
+  std::array<int,kMaxCodeLen + 2> count{}, next{};
+  for (int c = 0; c < 256; ++c) ++count[t.len[c]];
+  count[0] = 0;
+  for (int l = 1; l <= kMaxCodeLen; ++l) next[l + 1] = (next[l] + count[l]) << 1;
+  for (int c = 0; c < 256; ++c) if (t.len[c]) t.code[c] = static_cast<std::uint16_t>(next[t.len[c]]++);
+}
+
+// Huffman lengths, flattening the histogram until the deepest code fits.
+static CodeTable make_code_table(Histogram f) {
+  CodeTable t;
+  for (;;) {
+    std::array<int,256> len{};
+    code_lengths(f, len);
+    if (*std::max_element(len.begin(), len.end()) <= kMaxCodeLen) {
+      for (int c = 0; c < 256; ++c) t.len[c] = static_cast<std::uint8_t>(len[c]);
+      break;
+    }
+    for (auto& x : f) if (x) x = (x + 1) >> 1;
+  }
+  assign_canonical(t);
+  return t;
+}
+
+static DecodeTable make_decode_table(const CodeTable& t) {
+  DecodeTable d{};
+  std::uint32_t used = 0;
+  for (int c = 0; c < 256; ++c) {
+    const int l = t.len[c];
+    if (!l) continue;
+    if (l > kMaxCodeLen) throw std::runtime_error("huffman: code length out of range");
+    const std::uint32_t span = 1u << (kMaxCodeLen - l);
+    used += span;
+    if (used > d.size()) throw std::runtime_error("huffman: over-subscribed code table");
+    const std::uint32_t first = std::uint32_t(t.code[c]) << (kMaxCodeLen - l);
+    for (std::uint32_t k = 0; k < span; ++k) d[first + k] = {static_cast<std::uint8_t>(c), static_cast<std::uint8_t>(l)};
+  }
+  return d;
+}
+
+static void put_u32(std::vector<std::uint8_t>& out, std::uint32_t v) {
+  for (int i = 0; i < 4; ++i) out.push_back(static_cast<std::uint8_t>(v >> (8 * i)));
+}
+static void put_u64(std::vector<std::uint8_t>& out, std::uint64_t v) {
+  for (int i = 0; i < 8; ++i) out.push_back(static_cast<std::uint8_t>(v >> (8 * i)));
+}
+
+struct ByteReader {
+  std::span<const std::uint8_t> in;
+  std::size_t pos = 0;
+  std::span<const std::uint8_t> take(std::size_t n) {
+    if (in.size() - pos < n) throw std::runtime_error("huffman: truncated input");
+    auto s = in.subspan(pos, n);
+    pos += n;
+    return s;
+  }
+  std::uint32_t u32() { auto s = take(4); std::uint32_t v = 0; for (int i = 3; i >= 0; --i) v = v << 8 | s[i]; return v; }
+  std::uint64_t u64() { auto s = take(8); std::uint64_t v = 0; for (int i = 7; i >= 0; --i) v = v << 8 | s[i]; return v; }
+};
+
+static void put_lengths(std::vector<std::uint8_t>& out, const CodeTable& t) {
+  for (int c = 0; c < 256; c += 2) out.push_back(static_cast<std::uint8_t>(t.len[c] | t.len[c + 1] << 4));
+}
+static CodeTable get_lengths(ByteReader& br) {
+  CodeTable t;
+  auto s = br.take(128);
+  for (int c = 0; c < 256; c += 2) { t.len[c] = s[c / 2] & 15; t.len[c + 1] = s[c / 2] >> 4; }
+  for (auto l : t.len) if (l > kMaxCodeLen) throw std::runtime_error("huffman: code length out of range");
+  assign_canonical(t);
+  return t;
+}
+
+struct BitWriter {
+  std::uint8_t* out;
+  std::uint64_t acc = 0;
+  int cnt = 0;
+  void put(std::uint32_t code, int len) {
+    acc = acc << len | code;
+    cnt += len;
+    if (cnt >= 32) {
+      cnt -= 32;
+      const auto w = static_cast<std::uint32_t>(acc >> cnt);
+      out[0] = w >> 24; out[1] = w >> 16; out[2] = w >> 8; out[3] = w;
+      out += 4;
+    }
+  }
+  std::uint8_t* finish() {
+    for (; cnt >= 8; cnt -= 8) *out++ = static_cast<std::uint8_t>(acc >> (cnt - 8));
+    if (cnt) *out++ = static_cast<std::uint8_t>(acc << (8 - cnt));
+    cnt = 0;
+    return out;
+  }
+};
+
+// Bits are kept left-aligned in buf; reads past the end see zero padding.
+struct BitReader {
+  const std::uint8_t* p;
+  const std::uint8_t* end;
+  std::uint64_t buf = 0;
+  int cnt = 0;
+  void refill() {
+    for (; cnt <= 56; cnt += 8) buf |= std::uint64_t(p < end ? *p++ : 0) << (56 - cnt);
+  }
+  std::uint8_t decode(const DecodeTable& d) {
+    const auto e = d[buf >> (64 - kMaxCodeLen)];
+    buf <<= e.len;
+    cnt -= e.len;
+    return e.sym;
+  }
+};
+
+static std::array<std::size_t,kStreams> quarter_sizes(std::size_t n) {
+  const std::size_t q = (n + kStreams - 1) / kStreams;
+  std::array<std::size_t,kStreams> s{};
+  for (int i = 0; i < kStreams; ++i) s[i] = std::min(q, n - std::min(n, q * i));
+  return s;
+}
+
+// Appends one chunk record. With shared == nullptr the chunk gets its own table.
+static void encode_chunk(std::span<const std::uint8_t> in, const CodeTable* shared, std::vector<std::uint8_t>& out) {
+  CodeTable own;
+  if (!shared) own = make_code_table(histogram(in));
+  const CodeTable& t = shared ? *shared : own;
+
+  const auto qs = quarter_sizes(in.size());
+  std::array<std::vector<std::uint8_t>,kStreams> streams;
+  for (int s = 0, off = 0; s < kStreams; off += static_cast<int>(qs[s]), ++s) {
+    auto& buf = streams[s];
+    buf.resize(qs[s] * kMaxCodeLen / 8 + 8);
+    BitWriter bw{buf.data()};
+    for (auto b : in.subspan(off, qs[s])) {
+      if (!t.len[b]) throw std::runtime_error("huffman: symbol missing from shared table");
+      bw.put(t.code[b], t.len[b]);
+    }
+    buf.resize(bw.finish() - buf.data());
+  }
+
+  std::size_t payload = (shared ? 0 : 128) + 4 * (kStreams - 1);
+  for (auto& s : streams) payload += s.size();
+  put_u32(out, static_cast<std::uint32_t>(in.size()));
+  put_u32(out, static_cast<std::uint32_t>(payload));
+  if (!shared) put_lengths(out, t);
+  for (int s = 0; s + 1 < kStreams; ++s) put_u32(out, static_cast<std::uint32_t>(streams[s].size()));
+  for (auto& s : streams) out.insert(out.end(), s.begin(), s.end());
+}
 
+// Decodes one chunk payload into out (exactly raw_size bytes).
+static void decode_chunk(std::span<const std::uint8_t> payload, const DecodeTable* shared, std::uint8_t* out, std::size_t raw_size) {
+  ByteReader br{payload};
+  DecodeTable own;
+  if (!shared) own = make_decode_table(get_lengths(br));
+  const DecodeTable& d = shared ? *shared : own;
+
+  std::array<std::size_t,kStreams> ss{};
+  for (int s = 0; s + 1 < kStreams; ++s) ss[s] = br.u32();
+  ss[kStreams - 1] = payload.size() - br.pos;
+  for (int s = 0; s + 1 < kStreams; ++s) ss[kStreams - 1] -= std::min(ss[kStreams - 1], ss[s]);
+
+  std::array<BitReader,kStreams> rd;
+  for (int s = 0; s < kStreams; ++s) {
+    auto bytes = br.take(ss[s]);
+    rd[s] = {bytes.data(), bytes.data() + bytes.size()};
+  }
+  const auto qs = quarter_sizes(raw_size);
+  std::array<std::uint8_t*,kStreams> dst;
+  for (int s = 0; s < kStreams; ++s) dst[s] = out + qs[0] * s;
+
+  // 4 symbols per stream per refill: 4 * kMaxCodeLen <= 57 buffered bits.
+  const std::size_t tail = qs[kStreams - 1];
+  std::size_t i = 0;
+  for (; i + 4 <= tail; i += 4) {
+    for (auto& r : rd) r.refill();
+    for (int k = 0; k < 4; ++k) {
+      dst[0][i + k] = rd[0].decode(d);
+      dst[1][i + k] = rd[1].decode(d);
+      dst[2][i + k] = rd[2].decode(d);
+      dst[3][i + k] = rd[3].decode(d);
+    }
+  }
+  for (int s = 0; s < kStreams; ++s)
+    for (std::size_t j = i; j < qs[s]; ++j) { rd[s].refill(); dst[s][j] = rd[s].decode(d); }
+}
+
+using Sink = std::function<void(std::span<const std::uint8_t>)>;
+
+// Streams the container to sink, keeping at most batch_chunks encoded chunks
+// in memory at a time.
+void huffman_compress_stream(std::span<const std::uint8_t> in, const ChunkedOptions& opt, const Sink& sink) {
+  if (opt.chunk_size == 0 || opt.chunk_size > std::numeric_limits<std::uint32_t>::max() / kMaxCodeLen)
+    throw std::invalid_argument("huffman_compress: bad chunk size");
+  const std::size_t cs = opt.chunk_size;
+  const std::size_t chunks = (in.size() + cs - 1) / cs;
+  const std::size_t batch = opt.batch_chunks ? opt.batch_chunks : 4 * resolve_threads(opt.threads);
+
+  std::vector<std::uint8_t> hdr;
+  put_u32(hdr, kMagic);
+  put_u32(hdr, static_cast<std::uint32_t>(cs));
+  put_u64(hdr, in.size());
+  hdr.push_back(opt.shared_table ? kSharedTable : 0);
+  CodeTable shared;
+  if (opt.shared_table) {
+    shared = make_code_table(parallel_histogram(in, cs, opt.threads));
+    put_lengths(hdr, shared);
+  }
+  sink(hdr);
+
+  std::vector<std::vector<std::uint8_t>> parts(std::min(batch, chunks));
+  for (std::size_t base = 0; base < chunks; base += batch) {
+    const std::size_t n = std::min(batch, chunks - base);
+    parallel_for(n, opt.threads, [&](std::size_t k) {
+      const std::size_t i = base + k;
+      auto piece = in.subspan(i * cs, std::min(cs, in.size() - i * cs));
+      parts[k].clear();
+      parts[k].reserve(piece.size() / 2 + 256);
+      encode_chunk(piece, opt.shared_table ? &shared : nullptr, parts[k]);
+    });
+    for (std::size_t k = 0; k < n; ++k) sink(parts[k]);
+  }
+}
+
+std::vector<std::uint8_t> huffman_compress(std::span<const std::uint8_t> in, const ChunkedOptions& opt = {}) {
+  std::vector<std::uint8_t> out;
+  out.reserve(in.size() / 2 + 256);
+  huffman_compress_stream(in, opt, [&](std::span<const std::uint8_t> s) { out.insert(out.end(), s.begin(), s.end()); });
+  return out;
+}
+
+struct ContainerHeader {
+  std::size_t chunk_size;
+  std::uint64_t raw_size;
+  std::optional<DecodeTable> shared;
+};
+
+struct ChunkRef { std::span<const std::uint8_t> payload; std::size_t raw_size; };
+
+static ContainerHeader read_header(ByteReader& br) {
+  if (br.u32() != kMagic) throw std::runtime_error("huffman: bad magic");
+  ContainerHeader h;
+  h.chunk_size = br.u32();
+  h.raw_size = br.u64();
+  const std::uint8_t flags = br.take(1)[0];
+  if (h.chunk_size == 0) throw std::runtime_error("huffman: bad chunk size");
+  if (flags & kSharedTable) h.shared = make_decode_table(get_lengths(br));
+  return h;
+}
+
+static ChunkRef read_chunk(ByteReader& br, const ContainerHeader& h, std::uint64_t done) {
+  const std::size_t n = br.u32();
+  if (n != std::min<std::uint64_t>(h.chunk_size, h.raw_size - done)) throw std::runtime_error("huffman: bad chunk length");
+  return {br.take(br.u32()), n};
+}
+
+// Decodes batch_chunks chunks at a time into one reusable buffer handed to sink.
+void huffman_decompress_stream(std::span<const std::uint8_t> in, unsigned threads, std::size_t batch_chunks, const Sink& sink) {
+  ByteReader br{in};
+  const auto h = read_header(br);
+  const std::size_t batch = batch_chunks ? batch_chunks : 4 * resolve_threads(threads);
+  const DecodeTable* shared = h.shared ? &*h.shared : nullptr;
+
+  std::vector<ChunkRef> refs;
+  std::vector<std::uint8_t> buf;
+  for (std::uint64_t done = 0; done < h.raw_size; ) {
+    refs.clear();
+    std::size_t bytes = 0;
+    while (refs.size() < batch && done < h.raw_size) {
+      refs.push_back(read_chunk(br, h, done));
+      bytes += refs.back().raw_size;
+      done += refs.back().raw_size;
+    }
+    buf.resize(bytes);
+    parallel_for(refs.size(), threads, [&](std::size_t k) {
+      decode_chunk(refs[k].payload, shared, buf.data() + k * h.chunk_size, refs[k].raw_size);
+    });
+    sink(buf);
+  }
+}
+
+std::vector<std::uint8_t> huffman_decompress(std::span<const std::uint8_t> in, unsigned threads = 0) {
+  ByteReader br{in};
+  const auto h = read_header(br);
+  std::vector<ChunkRef> chunks;
+  for (std::uint64_t done = 0; done < h.raw_size; done += chunks.back().raw_size) chunks.push_back(read_chunk(br, h, done));
+
+  std::vector<std::uint8_t> out(h.raw_size);
+  parallel_for(chunks.size(), threads, [&](std::size_t i) {
+    decode_chunk(chunks[i].payload, h.shared ? &*h.shared : nullptr, out.data() + i * h.chunk_size, chunks[i].raw_size);
+  });
+  return out;
+}
+
+// ---------------------------------------------------------------------------
+// File I/O for the command line tool: inputs are mapped read-only and read
+// sequentially, outputs go through one large write buffer.
+// ---------------------------------------------------------------------------
+
+class MappedFile {
+  const std::uint8_t* data_ = nullptr;
+  std::size_t size_ = 0;
+
+public:
+  explicit MappedFile(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::system_error(errno, std::generic_category(), path);
+    struct stat st{};
+    if (::fstat(fd, &st) < 0) { const int e = errno; ::close(fd); throw std::system_error(e, std::generic_category(), path); }
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_) {
+      void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED) { const int e = errno; ::close(fd); throw std::system_error(e, std::generic_category(), path); }
+      ::madvise(p, size_, MADV_SEQUENTIAL);
+      data_ = static_cast<const std::uint8_t*>(p);
+    }
+    ::close(fd);
+  }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile() { if (data_) ::munmap(const_cast<std::uint8_t*>(data_), size_); }
+
+  [[nodiscard]] std::span<const std::uint8_t> bytes() const noexcept { return {data_, size_}; }
+
+};
+
+class BufferedOutput {
+  int fd_;
+  std::string path_;
+  std::vector<std::uint8_t> buf_;
+  std::uint64_t written_ = 0;
+
+  void write_all(const std::uint8_t* p, std::size_t n) {
+    while (n) {
+      const ssize_t w = ::write(fd_, p, n);
+      if (w < 0) {
+        if (errno == EINTR) continue;
+        throw std::system_error(errno, std::generic_category(), path_);
+      }
+      p += w; n -= static_cast<std::size_t>(w);
+    }
+  }
+
+public:
+  BufferedOutput(const std::string& path, std::size_t capacity = 8 << 20) : path_(path) {
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) throw std::system_error(errno, std::generic_category(), path);
+    buf_.reserve(capacity);
+  }
+  BufferedOutput(const BufferedOutput&) = delete;
+  BufferedOutput& operator=(const BufferedOutput&) = delete;
+  ~BufferedOutput() { ::close(fd_); }
+
+  void write(std::span<const std::uint8_t> s) {
+    written_ += s.size();
+    if (buf_.size() + s.size() > buf_.capacity()) flush();
+    if (s.size() >= buf_.capacity()) { write_all(s.data(), s.size()); return; }
+    buf_.insert(buf_.end(), s.begin(), s.end());
+  }
+  void flush() {
+    write_all(buf_.data(), buf_.size());
+    buf_.clear();
+  }
+  [[nodiscard]] std::uint64_t written() const noexcept { return written_; }
+};
+
+static int usage() {
+  std::cerr << "usage: huffman compress   <in> <out> [-c chunk_kib] [-t threads] [-s]\n"
+               "       huffman decompress <in> <out> [-t threads]\n"
+               "       huffman demo\n"
+               "  -c  chunk size in KiB (default 256)\n"
+               "  -t  worker threads (default: all cores)\n"
+               "  -s  one shared code table instead of one per chunk\n";
+  return 2;
+}
+
+static int demo() {
   std::string text = "huffman coding made simple";
   std::vector<std::uint8_t> bytes(text.begin(), text.end());
   auto enc = huffman_encode(bytes);
 
   std::cout << enc.bits.size() << "\n";
   std::cout << enc.bits.substr(0, 128) << (enc.bits.size() > 128 ? "..." : "") << "\n";
-  
+
+  std::mt19937 rng(2025);
+  std::vector<std::uint8_t> big(8 << 20);
+  for (auto& b : big) b = text[rng() % text.size()];
+  for (bool shared : {false, true}) {
+    auto packed = huffman_compress(big, {.shared_table = shared});
+    auto back = huffman_decompress(packed);
+    std::cout << (shared ? "shared" : "per-chunk") << ": " << big.size() << " -> " << packed.size()
+              << (back == big ? " ok" : " MISMATCH") << "\n";
+  }
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  std::ios::sync_with_stdio(false);
+  std::cin.tie(nullptr);
+  std::cout.tie(nullptr);
+
+  std::vector<std::string_view> args(argv + 1, argv + argc);
+  if (args.empty() || args[0] == "demo") return demo();
+  if (args.size() < 3 || (args[0] != "compress" && args[0] != "decompress")) return usage();
+  const bool compress = args[0] == "compress";
+
+  ChunkedOptions opt;
+  for (std::size_t i = 3; i < args.size(); ++i) {
+    if (args[i] == "-s") { opt.shared_table = true; continue; }
+    unsigned long v = 0;
+    if ((args[i] != "-c" && args[i] != "-t") || i + 1 == args.size()) return usage();
+    const auto val = args[++i];
+    if (std::from_chars(val.data(), val.data() + val.size(), v).ec != std::errc{}) return usage();
+    if (args[i - 1] == "-c") opt.chunk_size = v << 10; else opt.threads = static_cast<unsigned>(v);
+  }
+
+  try {
+    const auto t0 = std::chrono::steady_clock::now();
+    MappedFile in{std::string(args[1])};
+    BufferedOutput out{std::string(args[2])};
+    if (compress) {
+      huffman_compress_stream(in.bytes(), opt, [&](std::span<const std::uint8_t> s) { out.write(s); });
+    } else {
+      huffman_decompress_stream(in.bytes(), opt.threads, 0, [&](std::span<const std::uint8_t> s) { out.write(s); });
+    }
+    out.flush();
+
+    const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    const double raw = static_cast<double>(compress ? in.bytes().size() : out.written());
+    const double packed = static_cast<double>(compress ? out.written() : in.bytes().size());
+    std::cerr << std::fixed << std::setprecision(2)
+              << args[0] << ": " << in.bytes().size() << " -> " << out.written() << " bytes, "
+              << "ratio " << (packed ? raw / packed : 0.0) << ", "
+              << secs << " s, " << (secs > 0 ? raw / secs / (1 << 20) : 0.0) << " MiB/s\n";
+  } catch (const std::exception& e) {
+    std::cerr << "error: " << e.what() << "\n";
+    return 1;
+  }
   return 0;
 }
@@ -1,4 +1,14 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 struct TNode {
@@ -61,11 +71,389 @@ std::vector<int> inorder_traverse_threaded(TNode* root) {
   return seq;
 }
 
-int main() {
+// Fixed-size node allocator: nodes are carved out of growing blocks and
+// recycled through an intrusive free list, so insert/erase never hit malloc
+// once the pool has warmed up.
+template <class N>
+class NodePool {
+  union Slot {
+    Slot* next;
+    alignas(N) unsigned char storage[sizeof(N)];
+  };
+
+  std::vector<std::unique_ptr<Slot[]>> blocks_;
+  Slot* free_ = nullptr;
+  std::size_t next_block_ = 64;
+
+public:
+  NodePool() = default;
+  NodePool(const NodePool&) = delete;
+  NodePool& operator=(const NodePool&) = delete;
+
+  template <class... Args>
+  N* create(Args&&... args) {
+    if (!free_) {
+      blocks_.push_back(std::make_unique<Slot[]>(next_block_));
+      Slot* b = blocks_.back().get();
+      for (std::size_t i = next_block_; i-- > 0; ) { b[i].next = free_; free_ = &b[i]; }
+      next_block_ = std::min<std::size_t>(next_block_ * 2, 4096);
+    }
+    Slot* s = free_;
+    free_ = s->next;
+    return ::new (static_cast<void*>(s->storage)) N(std::forward<Args>(args)...);
+  }
+
+  void destroy(N* n) noexcept {
+    n->~N();
+    Slot* s = reinterpret_cast<Slot*>(n);
+    s->next = free_;
+    free_ = s;
+  }
+};
+
+// Fully threaded BST kept threaded across insert/erase: a missing left child
+// is a thread to the inorder predecessor, a missing right child a thread to
+// the successor (nullptr at either end). Updates cost O(depth) and iteration
+// never needs a stack or a re-threading pass.
+template <class T, class Comp = std::less<T>>
+class ThreadedTree {
+  struct Node {
+    T val;
+    Node* left = nullptr;
+    Node* right = nullptr;
+    bool lthread = true;
+    bool rthread = true;
+    template <class U>
+    explicit Node(U&& v) : val(std::forward<U>(v)) {}
+  };
+
+  NodePool<Node> pool_;
+  Node* root_ = nullptr;
+  std::size_t size_ = 0;
+  [[no_unique_address]] Comp comp_{};
+
+  static Node* leftmost(Node* x) noexcept {
+    if (x) while (!x->lthread) x = x->left;
+    return x;
+  }
+  static Node* rightmost(Node* x) noexcept {
+    if (x) while (!x->rthread) x = x->right;
+    return x;
+  }
+  static Node* succ(Node* x) noexcept { return x->rthread ? x->right : leftmost(x->right); }
+
+  template <class U>
+  bool insert_impl(U&& v) {
+    if (!root_) { root_ = pool_.create(std::forward<U>(v)); ++size_; return true; }
+    Node* cur = root_;
+    for (;;) {
+      if (comp_(v, cur->val)) {
+        if (!cur->lthread) { cur = cur->left; continue; }
+        Node* n = pool_.create(std::forward<U>(v));
+        n->left = cur->left;
+        n->right = cur;
+        cur->left = n;
+        cur->lthread = false;
+        break;
+      }
+      if (comp_(cur->val, v)) {
+        if (!cur->rthread) { cur = cur->right; continue; }
+        Node* n = pool_.create(std::forward<U>(v));
+        n->right = cur->right;
+        n->left = cur;
+        cur->right = n;
+        cur->rthread = false;
+        break;
+      }
+      return false;
+    }
+    ++size_;
+    return true;
+  }
+
+  // Unlinks x, which has at most one real child, from par (nullptr for the root).
+  void unlink(Node* par, Node* x) noexcept {
+    Node* child = nullptr;
+    if (!x->lthread) {
+      child = x->left;
+      rightmost(child)->right = x->right;
+    } else if (!x->rthread) {
+      child = x->right;
+      leftmost(child)->left = x->left;
+    }
+
+    if (!par) {
+      root_ = child;
+    } else if (par->left == x && !par->lthread) {
+      if (child) par->left = child;
+      else { par->left = x->left; par->lthread = true; }
+    } else {
+      if (child) par->right = child;
+      else { par->right = x->right; par->rthread = true; }
+    }
+    pool_.destroy(x);
+    --size_;
+  }
+
+public:
+  class iterator {
+    Node* n_ = nullptr;
+    friend class ThreadedTree;
+    explicit iterator(Node* n) : n_(n) {}
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    iterator() = default;
+    reference operator*() const noexcept { return n_->val; }
+    pointer operator->() const noexcept { return &n_->val; }
+    iterator& operator++() noexcept { n_ = succ(n_); return *this; }
+    iterator operator++(int) noexcept { auto t = *this; ++*this; return t; }
+    bool operator==(const iterator&) const = default;
+  };
+
+  ThreadedTree() = default;
+  explicit ThreadedTree(Comp comp) : comp_(std::move(comp)) {}
+  ThreadedTree(const ThreadedTree&) = delete;
+  ThreadedTree& operator=(const ThreadedTree&) = delete;
+  ~ThreadedTree() { clear(); }
+
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+
+  [[nodiscard]] iterator begin() const noexcept { return iterator(leftmost(root_)); }
+  [[nodiscard]] iterator end() const noexcept { return iterator(); }
+
+  bool insert(const T& v) { return insert_impl(v); }
+  bool insert(T&& v) { return insert_impl(std::move(v)); }
+
+  [[nodiscard]] iterator find(const T& v) const {
+    Node* cur = root_;
+    while (cur) {
+      if (comp_(v, cur->val)) cur = cur->lthread ? nullptr : cur->left;
+      else if (comp_(cur->val, v)) cur = cur->rthread ? nullptr : cur->right;
+      else return iterator(cur);
+    }
+    return end();
+  }
+  [[nodiscard]] bool contains(const T& v) const { return find(v) != end(); }
+
+  bool erase(const T& v) {
+    Node* par = nullptr;
+    Node* cur = root_;
+    while (cur) {
+      if (comp_(v, cur->val)) { if (cur->lthread) return false; par = cur; cur = cur->left; }
+      else if (comp_(cur->val, v)) { if (cur->rthread) return false; par = cur; cur = cur->right; }
+      else break;
+    }
+    if (!cur) return false;
+    if (!cur->lthread && !cur->rthread) {
+      // Two children: take over the successor's value and remove the
+      // successor instead, which has no left child.
+      Node* sp = cur;
+      Node* s = cur->right;
+      while (!s->lthread) { sp = s; s = s->left; }
+      cur->val = std::move(s->val);
+      par = sp;
+      cur = s;
+    }
+    unlink(par, cur);
+    return true;
+  }
+
+  void clear() noexcept {
+    for (Node* cur = leftmost(root_); cur; ) {
+      Node* next = succ(cur);
+      pool_.destroy(cur);
+      cur = next;
+    }
+    root_ = nullptr;
+    size_ = 0;
+  }
+};
+
+// Threaded tree packed into one array: each node holds its key plus two 32-bit
+// links whose top bit is the thread flag, so an int tree costs 12 bytes per
+// key instead of 32 and an inorder walk streams through a single allocation.
+// relayout() renumbers nodes in inorder order to make that walk sequential.
+template <class T, class Comp = std::less<T>>
+class CompactThreadedTree {
+  static constexpr std::uint32_t kThread = 1u << 31;
+  static constexpr std::uint32_t kIndex = kThread - 1;
+  static constexpr std::uint32_t kNil = kIndex;
+
+  struct Node {
+    T val;
+    std::uint32_t left = kThread | kNil;
+    std::uint32_t right = kThread | kNil;
+  };
+
+  std::vector<Node> nodes_;
+  std::uint32_t root_ = kNil;
+  [[no_unique_address]] Comp comp_{};
+
+  static bool is_thread(std::uint32_t link) noexcept { return link & kThread; }
+  static std::uint32_t index(std::uint32_t link) noexcept { return link & kIndex; }
+
+  std::uint32_t leftmost(std::uint32_t i) const noexcept {
+    if (i != kNil) while (!is_thread(nodes_[i].left)) i = nodes_[i].left;
+    return i;
+  }
+  std::uint32_t rightmost(std::uint32_t i) const noexcept {
+    if (i != kNil) while (!is_thread(nodes_[i].right)) i = nodes_[i].right;
+    return i;
+  }
+  std::uint32_t succ(std::uint32_t i) const noexcept {
+    const std::uint32_t r = nodes_[i].right;
+    return is_thread(r) ? index(r) : leftmost(r);
+  }
+  std::uint32_t pred(std::uint32_t i) const noexcept {
+    const std::uint32_t l = nodes_[i].left;
+    return is_thread(l) ? index(l) : rightmost(l);
+  }
+
+public:
+  class const_iterator {
+    const CompactThreadedTree* t_ = nullptr;
+    std::uint32_t i_ = kNil;
+    friend class CompactThreadedTree;
+    const_iterator(const CompactThreadedTree* t, std::uint32_t i) : t_(t), i_(i) {}
+
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    const_iterator() = default;
+    reference operator*() const noexcept { return t_->nodes_[i_].val; }
+    pointer operator->() const noexcept { return &t_->nodes_[i_].val; }
+    const_iterator& operator++() noexcept { i_ = t_->succ(i_); return *this; }
+    const_iterator operator++(int) noexcept { auto c = *this; ++*this; return c; }
+    const_iterator& operator--() noexcept {
+      i_ = i_ == kNil ? t_->rightmost(t_->root_) : t_->pred(i_);
+      return *this;
+    }
+    const_iterator operator--(int) noexcept { auto c = *this; --*this; return c; }
+    bool operator==(const const_iterator& o) const noexcept { return i_ == o.i_; }
+  };
+  using iterator = const_iterator;
+
+  CompactThreadedTree() = default;
+  explicit CompactThreadedTree(Comp comp) : comp_(std::move(comp)) {}
+
+  [[nodiscard]] bool empty() const noexcept { return nodes_.empty(); }
+  [[nodiscard]] std::size_t size() const noexcept { return nodes_.size(); }
+  void reserve(std::size_t n) { nodes_.reserve(n); }
+
+  [[nodiscard]] const_iterator begin() const noexcept { return {this, leftmost(root_)}; }
+  [[nodiscard]] const_iterator end() const noexcept { return {this, kNil}; }
+
+  bool insert(T v) {
+    if (nodes_.size() >= kNil) throw std::length_error("CompactThreadedTree: too many nodes");
+    const auto n = static_cast<std::uint32_t>(nodes_.size());
+    if (root_ == kNil) { nodes_.push_back({std::move(v)}); root_ = n; return true; }
+    std::uint32_t cur = root_;
+    for (;;) {
+      Node& c = nodes_[cur];
+      if (comp_(v, c.val)) {
+        if (!is_thread(c.left)) { cur = c.left; continue; }
+        const std::uint32_t l = c.left;
+        c.left = n;
+        nodes_.push_back({std::move(v), l, kThread | cur});
+        return true;
+      }
+      if (comp_(c.val, v)) {
+        if (!is_thread(c.right)) { cur = c.right; continue; }
+        const std::uint32_t r = c.right;
+        c.right = n;
+        nodes_.push_back({std::move(v), kThread | cur, r});
+        return true;
+      }
+      return false;
+    }
+  }
+
+  [[nodiscard]] const_iterator find(const T& v) const {
+    std::uint32_t cur = root_;
+    while (cur != kNil) {
+      const Node& c = nodes_[cur];
+      if (comp_(v, c.val)) cur = is_thread(c.left) ? kNil : c.left;
+      else if (comp_(c.val, v)) cur = is_thread(c.right) ? kNil : c.right;
+      else return {this, cur};
+    }
+    return end();
+  }
+  [[nodiscard]] bool contains(const T& v) const { return find(v) != end(); }
+
+  // Renumbers nodes so that index order equals inorder; links keep their flags.
+  void relayout() {
+    if (nodes_.empty()) return;
+    std::vector<std::uint32_t> order(nodes_.size()), pos(nodes_.size());
+    std::uint32_t k = 0;
+    for (std::uint32_t i = leftmost(root_); i != kNil; i = succ(i)) { order[k] = i; pos[i] = k++; }
+    auto remap = [&](std::uint32_t link) { return index(link) == kNil ? link : (link & kThread) | pos[index(link)]; };
+    std::vector<Node> next;
+    next.reserve(nodes_.size());
+    for (std::uint32_t i : order) {
+      Node& n = nodes_[i];
+      next.push_back({std::move(n.val), remap(n.left), remap(n.right)});
+    }
+    root_ = pos[root_];
+    nodes_ = std::move(next);
+  }
+};
+
+static int bench(std::size_t n) {
+  std::mt19937 rng(42);
+  std::vector<int> keys(n);
+  for (std::size_t i = 0; i < n; ++i) keys[i] = static_cast<int>(i);
+  std::shuffle(keys.begin(), keys.end(), rng);
+
+  auto time = [](auto&& f) {
+    const auto t0 = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  };
+  std::vector<int> seq;
+  auto report = [&](std::string_view name, double secs) {
+    std::cout << name << ": " << secs * 1e3 << " ms, " << n / secs / 1e6 << " Mkeys/s"
+              << (std::is_sorted(seq.begin(), seq.end()) && seq.size() == n ? "" : " (wrong output)") << '\n';
+  };
+
+  TNode* root = nullptr;
+  for (int v : keys) root = bst_insert(root, v);
+  inorder_thread(root);
+  report("TNode inorder_traverse_threaded", time([&] { seq = inorder_traverse_threaded(root); }));
+
+  CompactThreadedTree<int> ct;
+  ct.reserve(n);
+  for (int v : keys) ct.insert(v);
+  auto walk = [&] {
+    seq.clear();
+    seq.reserve(ct.size());
+    for (int v : ct) seq.push_back(v);
+  };
+  report("compact (insertion order)", time(walk));
+  ct.relayout();
+  report("compact (inorder layout)", time(walk));
+  std::cout << "bytes/node: TNode " << sizeof(TNode) << ", compact " << sizeof(int) + 2 * sizeof(std::uint32_t) << '\n';
+  return 0;
+}
+
+int main(int argc, char** argv) {
   std::ios::sync_with_stdio(false);
   std::cin.tie(nullptr);
   std::cout.tie(nullptr);
 
+  if (argc > 1 && std::string_view(argv[1]) == "bench")
+    return bench(argc > 2 ? std::stoul(argv[2]) : 10'000'000);
+
   std::vector <int> a = {8, 3, 10, 1, 6, 14, 4, 7, 13};
   TNode* root = nullptr;
   for (int v : a) root = bst_insert(root, v);
@@ -74,5 +462,18 @@ int main() {
   for (int v : seq) std::cout << v << ' ';
   std::cout << '\n';
 
+  ThreadedTree<int> tt;
+  for (int v : a) tt.insert(v);
+  tt.erase(3);
+  tt.erase(8);
+  tt.insert(5);
+  for (int v : tt) std::cout << v << ' ';
+  std::cout << '\n';
+
+  CompactThreadedTree<int> ct;
+  for (int v : a) ct.insert(v);
+  for (auto it = ct.end(); it != ct.begin(); ) std::cout << *--it << ' ';
+  std::cout << '\n';
+
   return 0;
 }
@@ -1,181 +1,601 @@
+#pragma once
 #include <algorithm>
+#include <bit>
 #include <cassert>
 #include <concepts>
+#include <cstdint>
 #include <functional>
+#include <future>
 #include <initializer_list>
 #include <iostream>
+#include <iterator>
 #include <memory>
+#include <new>
 #include <optional>
 #include <ranges>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
 #include <utility>
 #include <vector>
+#include "../common/flat_snapshot.h"
+#include "../common/stats.h"
 
 template <typename Comp, typename Key>
 concept KeyComparator = std::strict_weak_order<Comp, Key, Key>;
 
+// Node storage for the trees below: nodes live in fixed-size blocks addressed
+// by 32-bit indices and freed slots are chained into a free list. Blocks are
+// never moved, so references to stored values stay valid until erase.
+template <typename N>
+class node_arena {
+  public:
+    using index = std::uint32_t;
+    static constexpr index nil = static_cast<index>(-1);
+
+  private:
+    static constexpr unsigned kShift = 10;
+    static constexpr index kBlock = index{1} << kShift;
+
+    struct Slot { alignas(N) unsigned char raw[sizeof(N)]; };
+
+    std::vector<std::unique_ptr<Slot[]>> blocks_{};
+    index free_ = nil;
+    index used_ = 0;
+
+    void* slot(index i) const noexcept { return blocks_[i >> kShift][i & (kBlock - 1)].raw; }
+    index& next_free(index i) const noexcept { return *static_cast<index*>(slot(i)); }
+
+  public:
+    node_arena() = default;
+    node_arena(node_arena&& o) noexcept
+      : blocks_(std::move(o.blocks_)), free_(std::exchange(o.free_, nil)), used_(std::exchange(o.used_, 0)) {}
+    node_arena& operator=(node_arena&& o) noexcept {
+      blocks_ = std::move(o.blocks_);
+      free_ = std::exchange(o.free_, nil);
+      used_ = std::exchange(o.used_, 0);
+      return *this;
+    }
+
+    N& operator[](index i) const noexcept { return *std::launder(static_cast<N*>(slot(i))); }
+
+    template <typename... Args>
+    index create(Args&&... args) {
+      index i;
+      if (free_ != nil) {
+        i = free_;
+        free_ = next_free(i);
+      } else {
+        if (used_ == nil) throw std::length_error("node_arena: index space exhausted");
+        if ((used_ >> kShift) == blocks_.size()) blocks_.push_back(std::make_unique<Slot[]>(kBlock));
+        i = used_++;
+      }
+      try {
+        ::new (slot(i)) N(std::forward<Args>(args)...);
+      } catch (...) {
+        next_free(i) = free_;
+        free_ = i;
+        throw;
+      }
+      return i;
+    }
+
+    void destroy(index i) noexcept {
+      (*this)[i].~N();
+      next_free(i) = free_;
+      free_ = i;
+    }
+
+    // Drops every node without running destructors; only for trivially destructible N
+    // or after the owner destroyed the live nodes itself.
+    void release() noexcept {
+      blocks_.clear();
+      free_ = nil;
+      used_ = 0;
+    }
+};
+
 template <typename Key, typename T, KeyComparator<Key> Compare = std::less<Key>>
 class avl_tree {
   private:
+    using index = std::uint32_t;
+    static constexpr index nil = node_arena<int>::nil;
+
     struct Node {
-      std::pair<Key, T> kv;
-      std::unique_ptr<Node> left{};
-      std::unique_ptr<Node> right{};
+      std::pair<const Key, T> kv;
+      index left = nil;
+      index right = nil;
+      index parent = nil;
       int height = 1;
 
       explicit Node(std::pair<Key, T>&& p) : kv(std::move(p)) {}
+      explicit Node(std::pair<const Key, T>&& p) : kv(std::move(p)) {}
       explicit Node(const Key& k, const T& v) : kv(k, v) {}
       template <typename... Args>
       Node(const Key& k, std::in_place_t, Args&&... args) : kv(k, T(std::forward<Args>(args)...)) {}
     };
 
-    std::unique_ptr<Node> root_{};
+    node_arena<Node> nodes_{};
+    index root_ = nil;
     std::size_t size_ = 0;
     [[no_unique_address]] Compare comp_{};
+    [[no_unique_address]] stats_counter stats_{};
 
-    static int height_of(const std::unique_ptr<Node>& n) noexcept { return n ? n->height : 0; }
-    static int bf_of(const std::unique_ptr<Node>& n) noexcept { return n ? height_of(n->left) - height_of(n->right) : 0; }
-    static void update(Node* n) noexcept {
-      n->height = 1 + std::max(height_of(n->left), height_of(n->right));
+    Node& at(index i) const noexcept { return nodes_[i]; }
+
+    bool less(const Key& a, const Key& b) const noexcept {
+      stats_.compare();
+      return comp_(a, b);
+    }
+    int height_of(index i) const noexcept { return i == nil ? 0 : at(i).height; }
+    int bf_of(index i) const noexcept { return height_of(at(i).left) - height_of(at(i).right); }
+    void update(index i) noexcept {
+      at(i).height = 1 + std::max(height_of(at(i).left), height_of(at(i).right));
     }
 
-    static void rotate_right(std::unique_ptr<Node>& y) noexcept {
-      auto x = std::move(y->left);
-      auto T2 = std::move(x->right);
-      x->right = std::move(y);
-      x->right->left = std::move(T2);
-      update(x->right.get());
-      update(x.get());
-      y = std::move(x);
+    void replace_child(index parent, index old_child, index new_child) noexcept {
+      if (new_child != nil) at(new_child).parent = parent;
+      if (parent == nil) root_ = new_child;
+      else if (at(parent).left == old_child) at(parent).left = new_child;
+      else at(parent).right = new_child;
     }
 
-    static void rotate_left(std::unique_ptr<Node>& x) noexcept {
-      auto y = std::move(x->right);
-      auto T2 = std::move(y->left);
-      y->left = std::move(x);
-      y->left->right = std::move(T2);
-      update(y->left.get());
-      update(y.get());
-      x = std::move(y);
+    index rotate_right(index y) noexcept {
+      const index x = at(y).left;
+      const index t2 = at(x).right;
+      stats_.rotate();
+      replace_child(at(y).parent, y, x);
+      at(y).left = t2;
+      if (t2 != nil) at(t2).parent = y;
+      at(x).right = y;
+      at(y).parent = x;
+      update(y);
+      update(x);
+      return x;
     }
 
-    static void rebalance(std::unique_ptr<Node>& n) noexcept {
-      update(n.get());
+    index rotate_left(index x) noexcept {
+      const index y = at(x).right;
+      const index t2 = at(y).left;
+      stats_.rotate();
+      replace_child(at(x).parent, x, y);
+      at(x).right = t2;
+      if (t2 != nil) at(t2).parent = x;
+      at(y).left = x;
+      at(x).parent = y;
+      update(x);
+      update(y);
+      return y;
+    }
+
+    // Rebalances the subtree at n and returns its (possibly new) root.
+    index rebalance(index n) noexcept {
+      update(n);
       const int bf = bf_of(n);
       if (bf > 1) {
-        if (bf_of(n->left) < 0) rotate_left(n->left);
-        rotate_right(n);
-      } else if (bf < -1) {
-        if (bf_of(n->right) > 0) rotate_right(n->right);
-        rotate_left(n);
+        if (bf_of(at(n).left) < 0) rotate_left(at(n).left);
+        return rotate_right(n);
       }
+      if (bf < -1) {
+        if (bf_of(at(n).right) > 0) rotate_right(at(n).right);
+        return rotate_left(n);
+      }
+      return n;
     }
 
-    Node* find_node(const Key& key) noexcept {
-      auto* cur = root_.get();
-      while (cur) {
-        if (comp_(key, cur->kv.first)) cur = cur->left.get();
-        else if (comp_(cur->kv.first, key)) cur = cur->right.get();
-        else return cur; 
+    // Walks from n towards the root after a structural change below n. Once a
+    // subtree ends up with the height it had before, nothing above it can be
+    // affected and the walk stops.
+    void fix_upwards(index n) noexcept {
+      while (n != nil) {
+        const int before = at(n).height;
+        n = rebalance(n);
+        if (at(n).height == before) return;
+        n = at(n).parent;
+      }
+    }
+
+    index leftmost(index n) const noexcept {
+      if (n != nil) while (at(n).left != nil) n = at(n).left;
+      return n;
+    }
+
+    index rightmost(index n) const noexcept {
+      if (n != nil) while (at(n).right != nil) n = at(n).right;
+      return n;
+    }
+
+    index successor(index n) const noexcept {
+      if (at(n).right != nil) return leftmost(at(n).right);
+      index p = at(n).parent;
+      while (p != nil && n == at(p).right) { n = p; p = at(p).parent; }
+      return p;
+    }
+
+    index predecessor(index n) const noexcept {
+      if (at(n).left != nil) return rightmost(at(n).left);
+      index p = at(n).parent;
+      while (p != nil && n == at(p).left) { n = p; p = at(p).parent; }
+      return p;
+    }
+
+    // First node whose key is not less than (Upper: greater than) key.
+    template <bool Upper>
+    index bound(const Key& key) const noexcept {
+      index cur = root_, best = nil;
+      std::uint64_t depth = 0;
+      while (cur != nil) {
+        const Node& n = at(cur);
+        stats_.visit();
+        ++depth;
+        const bool go_left = Upper ? less(key, n.kv.first) : !less(n.kv.first, key);
+        if (go_left) { best = cur; cur = n.left; }
+        else cur = n.right;
       }
-      return nullptr;
+      stats_.depth(depth);
+      return best;
+    }
+
+    index find_index(const Key& key) const noexcept {
+      index cur = root_;
+      std::uint64_t depth = 0;
+      while (cur != nil) {
+        const Node& n = at(cur);
+        stats_.visit();
+        ++depth;
+        if (less(key, n.kv.first)) cur = n.left;
+        else if (less(n.kv.first, key)) cur = n.right;
+        else break;
+      }
+      stats_.depth(depth);
+      return cur;
+    }
+
+    Node* find_node(const Key& key) noexcept {
+      const index i = find_index(key);
+      return i == nil ? nullptr : &at(i);
     }
 
     const Node* find_node(const Key& key) const noexcept {
-      auto* cur = root_.get();
-      while (cur) {
-        if (comp_(key, cur->kv.first)) cur = cur->left.get();
-        else if (comp_(cur->kv.first, key)) cur = cur->right.get();
-        else return cur;
+      const index i = find_index(key);
+      return i == nil ? nullptr : &at(i);
+    }
+
+    // Either finds key or creates it with make_node() at the leaf position it
+    // belongs to; the path is rebalanced bottom-up without recursion.
+    template <typename Make>
+    std::pair<index, bool> find_or_insert(const Key& key, Make&& make_node) {
+      index parent = nil, cur = root_;
+      bool go_left = false;
+      std::uint64_t depth = 0;
+      while (cur != nil) {
+        const Node& n = at(cur);
+        stats_.visit();
+        ++depth;
+        if (less(key, n.kv.first)) { parent = cur; cur = n.left; go_left = true; }
+        else if (less(n.kv.first, key)) { parent = cur; cur = n.right; go_left = false; }
+        else break;
       }
-      return nullptr;
+      stats_.depth(depth);
+      if (cur != nil) return {cur, false};
+      const index fresh = make_node();
+      stats_.allocate();
+      at(fresh).parent = parent;
+      if (parent == nil) root_ = fresh;
+      else if (go_left) at(parent).left = fresh;
+      else at(parent).right = fresh;
+      ++size_;
+      fix_upwards(parent);
+      return {fresh, true};
     }
 
-    std::pair<T&, bool> insert_or_assign_impl(std::unique_ptr<Node>& n, const Key& key, T&& value) {
-      if (!n) { n = std::make_unique<Node>(std::pair<Key, T>(key, std::move(value))); ++size_; return {n->kv.second, true}; }
-      if (comp_(key, n->kv.first)) {
-        auto [ref, ins] = insert_or_assign_impl(n->left, key, std::move(value));
-        rebalance(n);
-        return {ref, ins};
+    void erase_index(index n) noexcept {
+      index start;
+      if (at(n).left != nil && at(n).right != nil) {
+        // Relink the successor into n's position rather than moving values,
+        // so references to other elements stay valid.
+        const index s = leftmost(at(n).right);
+        if (s == at(n).right) {
+          start = s;
+        } else {
+          start = at(s).parent;
+          at(start).left = at(s).right;
+          if (at(s).right != nil) at(at(s).right).parent = start;
+          at(s).right = at(n).right;
+          at(at(s).right).parent = s;
+        }
+        at(s).left = at(n).left;
+        at(at(s).left).parent = s;
+        at(s).height = at(n).height;
+        replace_child(at(n).parent, n, s);
+      } else {
+        const index child = at(n).left != nil ? at(n).left : at(n).right;
+        start = at(n).parent;
+        replace_child(start, n, child);
       }
-      if (comp_(n->kv.first, key)) {
-        auto [ref, ins] = insert_or_assign_impl(n->right, key, std::move(value));
-        rebalance(n);
-        return {ref, ins};
+      nodes_.destroy(n);
+      --size_;
+      fix_upwards(start);
+    }
+
+    // ---- join-based bulk operations -------------------------------------
+    // These work on detached subtrees: a subtree root's parent link is only
+    // fixed up by whoever attaches it, and the top-level caller resets the
+    // final root's parent. None of them allocate, so disjoint subtrees can
+    // be processed on different threads.
+
+    struct split_result { index left, match, right; };
+
+    index make_node(index l, index k, index r) noexcept {
+      at(k).left = l;
+      at(k).right = r;
+      if (l != nil) at(l).parent = k;
+      if (r != nil) at(r).parent = k;
+      update(k);
+      return k;
+    }
+    index rot_left(index x) noexcept {
+      const index y = at(x).right;
+      make_node(at(x).left, x, at(y).left);
+      return make_node(x, y, at(y).right);
+    }
+    index rot_right(index y) noexcept {
+      const index x = at(y).left;
+      make_node(at(x).right, y, at(y).right);
+      return make_node(at(x).left, x, y);
+    }
+
+    // join_right/join_left descend the spine of the taller side until the
+    // heights meet, attach there and rotate on the way back up.
+    index join_right(index l, index k, index r) noexcept {
+      const index ll = at(l).left, c = at(l).right;
+      if (height_of(c) <= height_of(r) + 1) {
+        const index t = make_node(c, k, r);
+        if (height_of(t) <= height_of(ll) + 1) return make_node(ll, l, t);
+        return rot_left(make_node(ll, l, rot_right(t)));
+      }
+      const index t = join_right(c, k, r);
+      const index t2 = make_node(ll, l, t);
+      return height_of(t) <= height_of(ll) + 1 ? t2 : rot_left(t2);
+    }
+    index join_left(index l, index k, index r) noexcept {
+      const index c = at(r).left, rr = at(r).right;
+      if (height_of(c) <= height_of(l) + 1) {
+        const index t = make_node(l, k, c);
+        if (height_of(t) <= height_of(rr) + 1) return make_node(t, r, rr);
+        return rot_right(make_node(rot_left(t), r, rr));
       }
-      
-      n->kv.second = std::move(value);
-      return {n->kv.second, false};
+      const index t = join_left(l, k, c);
+      const index t2 = make_node(t, r, rr);
+      return height_of(t) <= height_of(rr) + 1 ? t2 : rot_right(t2);
     }
 
-    template <typename... Args>
-    std::pair<T&, bool> emplace_impl(std::unique_ptr<Node>& n, const Key& key, Args&&... args) {
-      if (!n) {
-        n = std::make_unique<Node>(key, std::in_place, std::forward<Args>(args)...);
-        ++size_;
-        return {n->kv.second, true};
+    // All keys in l < key(k) < all keys in r; O(|height(l) - height(r)|).
+    index join(index l, index k, index r) noexcept {
+      if (height_of(l) > height_of(r) + 1) return join_right(l, k, r);
+      if (height_of(r) > height_of(l) + 1) return join_left(l, k, r);
+      return make_node(l, k, r);
+    }
+
+    std::pair<index, index> split_last(index t) noexcept {
+      const index r = at(t).right;
+      if (r == nil) return {at(t).left, t};
+      auto [rest, last] = split_last(r);
+      return {join(at(t).left, t, rest), last};
+    }
+
+    index join2(index l, index r) noexcept {
+      if (l == nil) return r;
+      auto [rest, last] = split_last(l);
+      return join(rest, last, r);
+    }
+
+    // Splits t into keys < key, the node equal to key (or nil), keys > key.
+    split_result split_node(index t, const Key& key) noexcept {
+      if (t == nil) return {nil, nil, nil};
+      const index l = at(t).left, r = at(t).right;
+      if (comp_(key, at(t).kv.first)) {
+        auto s = split_node(l, key);
+        return {s.left, s.match, join(s.right, t, r)};
       }
-      if (comp_(key, n->kv.first)) {
-        auto [ref, ins] = emplace_impl(n->left, key, std::forward<Args>(args)...);
-        rebalance(n);
-        return {ref, ins};
+      if (comp_(at(t).kv.first, key)) {
+        auto s = split_node(r, key);
+        return {join(l, t, s.left), s.match, s.right};
       }
-      if (comp_(n->kv.first, key)) {
-        auto [ref, ins] = emplace_impl(n->right, key, std::forward<Args>(args)...);
-        rebalance(n);
-        return {ref, ins};
+      return {l, t, r};
+    }
+
+    index link_balanced(const index* ids, std::size_t n) noexcept {
+      if (!n) return nil;
+      const std::size_t mid = n / 2;
+      return make_node(link_balanced(ids, mid), ids[mid], link_balanced(ids + mid + 1, n - mid - 1));
+    }
+
+    // Whether detached subtree a has fewer nodes than b, found by walking both
+    // in step, so in O(min(|a|, |b|)).
+    bool fewer_nodes(index a, index b) const noexcept {
+      for (a = leftmost(a), b = leftmost(b); a != nil && b != nil; a = successor(a), b = successor(b)) {}
+      return a == nil && b != nil;
+    }
+
+    // Moves the subtree t of from (possibly this tree's own) into this arena
+    // as a perfectly balanced detached subtree; returns its root and size.
+    std::pair<index, std::size_t> adopt(avl_tree& from, index t) {
+      std::vector<index> src, ids;
+      if (t != nil) from.at(t).parent = nil;
+      for (index n = from.leftmost(t); n != nil; n = from.successor(n)) src.push_back(n);
+      ids.reserve(src.size());
+      try {
+        for (index n : src) ids.push_back(nodes_.create(std::move(from.at(n).kv)));
+      } catch (...) {
+        for (index n : ids) nodes_.destroy(n);
+        throw;
       }
-      
-      return {n->kv.second, false};
+      for (index n : src) from.nodes_.destroy(n);
+      return {link_balanced(ids.data(), ids.size()), ids.size()};
     }
 
-    static std::unique_ptr<Node> extract_min(std::unique_ptr<Node>& n) noexcept {
-      if (!n->left) {
-        auto min = std::move(n);
-        n = std::move(min->right);
-        return min;
+    void collect(index t, std::vector<index>& out) const {
+      if (t == nil) return;
+      std::vector<index> stack{t};
+      while (!stack.empty()) {
+        const index n = stack.back();
+        stack.pop_back();
+        out.push_back(n);
+        if (at(n).left != nil) stack.push_back(at(n).left);
+        if (at(n).right != nil) stack.push_back(at(n).right);
       }
-      auto min = extract_min(n->left);
-      rebalance(n);
-      return min;
     }
 
-    bool erase_impl(std::unique_ptr<Node>& n, const Key& key) {
-      if (!n) return false;
-      if (comp_(key, n->kv.first)) {
-        const bool ok = erase_impl(n->left, key);
-        if (ok) rebalance(n);
-        return ok;
+    // Subtrees shorter than this are not worth a task of their own.
+    static constexpr int kParallelHeight = 14;
+
+    // Runs both halves of a divide step, the second on its own thread while
+    // depth allows. Each side records the nodes it drops in its own list.
+    template <typename L, typename R>
+    static void fork2(bool parallel, std::vector<index>& drops, L&& left, R&& right) {
+      if (!parallel) { left(drops); right(drops); return; }
+      std::vector<index> side;
+      auto done = std::async(std::launch::async, [&] { right(side); });
+      left(drops);
+      done.get();
+      drops.insert(drops.end(), side.begin(), side.end());
+    }
+
+    bool worth_forking(int depth, index a, index b) const noexcept {
+      return depth > 0 && std::max(height_of(a), height_of(b)) > kParallelHeight;
+    }
+
+    index union_nodes(index a, index b, int depth, std::vector<index>& drops) {
+      if (a == nil) return b;
+      if (b == nil) return a;
+      const auto s = split_node(b, at(a).kv.first);
+      if (s.match != nil) drops.push_back(s.match);
+      const index la = at(a).left, ra = at(a).right;
+      index l = nil, r = nil;
+      fork2(worth_forking(depth, a, b), drops,
+            [&](auto& d) { l = union_nodes(la, s.left, depth - 1, d); },
+            [&](auto& d) { r = union_nodes(ra, s.right, depth - 1, d); });
+      return join(l, a, r);
+    }
+
+    index intersect_nodes(index a, index b, int depth, std::vector<index>& drops) {
+      if (a == nil || b == nil) {
+        collect(a, drops);
+        collect(b, drops);
+        return nil;
       }
-      if (comp_(n->kv.first, key)) {
-        const bool ok = erase_impl(n->right, key);
-        if (ok) rebalance(n);
-        return ok;
+      const auto s = split_node(b, at(a).kv.first);
+      const index la = at(a).left, ra = at(a).right;
+      index l = nil, r = nil;
+      fork2(worth_forking(depth, a, b), drops,
+            [&](auto& d) { l = intersect_nodes(la, s.left, depth - 1, d); },
+            [&](auto& d) { r = intersect_nodes(ra, s.right, depth - 1, d); });
+      if (s.match != nil) {
+        drops.push_back(s.match);
+        return join(l, a, r);
       }
+      drops.push_back(a);
+      return join2(l, r);
+    }
 
-      --size_;
-      if (!n->left) { n = std::move(n->right); return true; }
-      if (!n->right) { n = std::move(n->left); return true; }
-
-      auto left_sub = std::move(n->left);
-      auto right_sub = std::move(n->right);
-      auto min = extract_min(right_sub);
-      min->left = std::move(left_sub);
-      min->right = std::move(right_sub);
-      update(min.get());
-      n = std::move(min);
-      rebalance(n);
-      return true;
+    index difference_nodes(index a, index b, int depth, std::vector<index>& drops) {
+      if (a == nil || b == nil) {
+        collect(b, drops);
+        return a;
+      }
+      const auto s = split_node(a, at(b).kv.first);
+      const index lb = at(b).left, rb = at(b).right;
+      drops.push_back(b);
+      if (s.match != nil) drops.push_back(s.match);
+      index l = nil, r = nil;
+      fork2(worth_forking(depth, a, b), drops,
+            [&](auto& d) { l = difference_nodes(s.left, lb, depth - 1, d); },
+            [&](auto& d) { r = difference_nodes(s.right, rb, depth - 1, d); });
+      return join2(l, r);
     }
 
-    template <typename F>
-    static void inorder_node(Node* n, F&& f) {
-      if (!n) return;
-      inorder_node(n->left.get(), f);
-      std::invoke(f, n->kv.first, n->kv.second);
-      inorder_node(n->right.get(), f);
+    // Moves other into this arena, combines both trees with op and frees
+    // every node op dropped. Each input node is either kept or dropped.
+    template <typename Op>
+    void combine(avl_tree&& other, unsigned threads, Op op) {
+      if (this == &other) throw std::invalid_argument("avl_tree: set operation with itself");
+      const auto [b, m] = adopt(other, other.root_);
+      other.root_ = nil;
+      other.size_ = 0;
+      if (!threads) threads = std::max(1u, std::thread::hardware_concurrency());
+      std::vector<index> drops;
+      root_ = (this->*op)(root_, b, std::bit_width(threads) - 1, drops);
+      if (root_ != nil) at(root_).parent = nil;
+      size_ = size_ + m - drops.size();
+      for (index d : drops) nodes_.destroy(d);
     }
 
+    void destroy_all() noexcept {
+      if constexpr (!std::is_trivially_destructible_v<Node>) {
+        std::vector<index> stack;
+        if (root_ != nil) stack.push_back(root_);
+        while (!stack.empty()) {
+          const index n = stack.back();
+          stack.pop_back();
+          if (at(n).left != nil) stack.push_back(at(n).left);
+          if (at(n).right != nil) stack.push_back(at(n).right);
+          at(n).~Node();
+        }
+      }
+      nodes_.release();
+      root_ = nil;
+      size_ = 0;
+    }
+
+    template <typename Self, typename F>
+    static void inorder_node(Self& self, F&& f) {
+      for (index n = self.leftmost(self.root_); n != nil; n = self.successor(n))
+        std::invoke(f, self.at(n).kv.first, self.at(n).kv.second);
+    }
+
+    template <bool Const>
+    class basic_iterator {
+        using tree_ptr = std::conditional_t<Const, const avl_tree*, avl_tree*>;
+        tree_ptr tree_ = nullptr;
+        index n_ = nil;
+        friend class avl_tree;
+        basic_iterator(tree_ptr t, index n) noexcept : tree_(t), n_(n) {}
+
+      public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = std::pair<const Key, T>;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::conditional_t<Const, const value_type&, value_type&>;
+        using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+
+        basic_iterator() = default;
+        template <bool C = Const> requires C
+        basic_iterator(const basic_iterator<false>& o) noexcept : tree_(o.tree_), n_(o.n_) {}
+
+        reference operator*() const noexcept { return tree_->at(n_).kv; }
+        pointer operator->() const noexcept { return &tree_->at(n_).kv; }
+        basic_iterator& operator++() noexcept { n_ = tree_->successor(n_); return *this; }
+        basic_iterator operator++(int) noexcept { auto t = *this; ++*this; return t; }
+        // Decrementing end() yields the last element.
+        basic_iterator& operator--() noexcept {
+          n_ = n_ == nil ? tree_->rightmost(tree_->root_) : tree_->predecessor(n_);
+          return *this;
+        }
+        basic_iterator operator--(int) noexcept { auto t = *this; --*this; return t; }
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b) noexcept { return a.n_ == b.n_; }
+    };
+
   public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
     avl_tree() = default;
     explicit avl_tree(Compare comp) : comp_(std::move(comp)) {}
 
@@ -183,21 +603,34 @@ class avl_tree {
       for (auto&& p : init) insert_or_assign(std::move(p.first), std::move(p.second));
     }
 
+    avl_tree(avl_tree&& o) noexcept
+      : nodes_(std::move(o.nodes_)), root_(std::exchange(o.root_, nil)), size_(std::exchange(o.size_, 0)), comp_(std::move(o.comp_)) {}
+    avl_tree& operator=(avl_tree&& o) noexcept {
+      if (this != &o) {
+        destroy_all();
+        nodes_ = std::move(o.nodes_);
+        root_ = std::exchange(o.root_, nil);
+        size_ = std::exchange(o.size_, 0);
+        comp_ = std::move(o.comp_);
+      }
+      return *this;
+    }
+    ~avl_tree() { destroy_all(); }
+
     [[nodiscard]] auto size() const noexcept -> std::size_t { return size_; }
     [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
 
     auto insert_or_assign(const Key& key, T value) -> std::pair<T&, bool> {
-        auto res = insert_or_assign_impl(root_, key, std::move(value));
-        rebalance(root_);
-        return res;
+      auto [i, inserted] = find_or_insert(key, [&] { return nodes_.create(std::pair<Key, T>(key, std::move(value))); });
+      if (!inserted) at(i).kv.second = std::move(value);
+      return {at(i).kv.second, inserted};
     }
 
     template <typename... Args>
     requires std::constructible_from<T, Args...>
     auto emplace(const Key& key, Args&&... args) -> std::pair<T&, bool> {
-      auto res = emplace_impl(root_, key, std::forward<Args>(args)...);
-      rebalance(root_);
-      return res;
+      auto [i, inserted] = find_or_insert(key, [&] { return nodes_.create(key, std::in_place, std::forward<Args>(args)...); });
+      return {at(i).kv.second, inserted};
     }
 
     [[nodiscard]] T* find(const Key& key) noexcept { if (auto* n = find_node(key)) return &n->kv.second; return nullptr; }
@@ -206,20 +639,147 @@ class avl_tree {
     [[nodiscard]] bool contains(const Key& key) const noexcept { return find_node(key) != nullptr; }
 
     bool erase(const Key& key) {
-      const bool ok = erase_impl(root_, key);
-      if (root_) rebalance(root_);
-      return ok;
+      const index n = find_index(key);
+      if (n == nil) return false;
+      erase_index(n);
+      return true;
+    }
+
+    void clear() noexcept { destroy_all(); }
+
+    // Lookup and update counters; all zero unless built with DSA_STATS.
+    [[nodiscard]] container_stats stats() const noexcept { return stats_.get(); }
+    void reset_stats() noexcept { stats_.reset(); }
+
+    void swap(avl_tree& o) noexcept {
+      std::swap(nodes_, o.nodes_);
+      std::swap(root_, o.root_);
+      std::swap(size_, o.size_);
+      std::swap(comp_, o.comp_);
+    }
+
+    // O(n) construction from key/value pairs in strictly increasing key order.
+    template <std::ranges::input_range R>
+    requires std::constructible_from<std::pair<Key, T>, std::ranges::range_reference_t<R>>
+    [[nodiscard]] static avl_tree build_from_sorted(R&& r, Compare comp = {}) {
+      avl_tree t(std::move(comp));
+      std::vector<index> ids;
+      if constexpr (std::ranges::sized_range<R>) ids.reserve(std::ranges::size(r));
+      try {
+        for (auto&& p : r) {
+          ids.push_back(t.nodes_.create(std::pair<Key, T>(std::forward<decltype(p)>(p))));
+          if (ids.size() > 1 && !t.comp_(t.at(ids[ids.size() - 2]).kv.first, t.at(ids.back()).kv.first))
+            throw std::invalid_argument("avl_tree::build_from_sorted: keys not strictly increasing");
+        }
+      } catch (...) {
+        for (index i : ids) t.nodes_.destroy(i);
+        throw;
+      }
+      t.size_ = ids.size();
+      t.root_ = t.link_balanced(ids.data(), ids.size());
+      if (t.root_ != nil) t.at(t.root_).parent = nil;
+      return t;
+    }
+
+    // Writes the tree as a flat snapshot (common/flat_snapshot.h): sorted key
+    // and value arrays that flat_snapshot<Key, T, Compare> maps and queries
+    // in place, or that load() turns back into a tree.
+    void save(const std::string& path) const requires flat_storable<Key, T> {
+      write_flat_snapshot<Key, T>(path, size_, [this](auto&& emit) { for_each_inorder(emit); });
+    }
+
+    // Rebuilds a tree saved by save() in O(n) with one sequential pass over
+    // the mapped file instead of n insertions.
+    [[nodiscard]] static avl_tree load(const std::string& path, Compare comp = {}) requires flat_storable<Key, T> {
+      const flat_snapshot<Key, T, Compare> file(path, comp);
+      return build_from_sorted(file, std::move(comp));
+    }
+
+    // Appends greater, whose keys must all compare greater than ours, in
+    // O(min(m, n)): the smaller tree is moved into the larger one's arena,
+    // then the two are joined in O(log n).
+    void join(avl_tree&& greater) {
+      if (this == &greater || greater.empty()) return;
+      if (empty()) { swap(greater); return; }
+      if (!comp_(at(rightmost(root_)).kv.first, greater.at(greater.leftmost(greater.root_)).kv.first))
+        throw std::invalid_argument("avl_tree::join: key ranges overlap");
+      const bool swapped = greater.size_ > size_;
+      if (swapped) swap(greater);
+      const auto [b, m] = adopt(greater, greater.root_);
+      greater.root_ = nil;
+      greater.size_ = 0;
+      root_ = swapped ? join2(b, root_) : join2(root_, b);
+      at(root_).parent = nil;
+      size_ += m;
+    }
+
+    // Keeps the keys < key and returns a tree with the keys >= key, in
+    // O(log n + min(m, n)) for halves of m and n keys: the split itself is
+    // O(log n), then the smaller half is moved to an arena of its own and the
+    // larger one keeps this tree's.
+    [[nodiscard]] avl_tree split(const Key& key) {
+      auto s = split_node(root_, key);
+      const index left = s.left;
+      const index right = s.match == nil ? s.right : join(nil, s.match, s.right);
+      if (left != nil) at(left).parent = nil;
+      if (right != nil) at(right).parent = nil;
+      const bool move_left = !fewer_nodes(right, left);
+      avl_tree out(comp_);
+      const auto [r, m] = out.adopt(*this, move_left ? left : right);
+      out.root_ = r;
+      out.size_ = m;
+      root_ = move_left ? right : left;
+      size_ -= m;
+      if (move_left) swap(out);
+      return out;
     }
 
+    // Set operations on keys, consuming other. Where both trees hold a key,
+    // the value already in *this is kept. threads == 0 uses every core;
+    // recursion forks while subtrees stay large.
+    void union_with(avl_tree&& other, unsigned threads = 0) { combine(std::move(other), threads, &avl_tree::union_nodes); }
+    void intersect_with(avl_tree&& other, unsigned threads = 0) { combine(std::move(other), threads, &avl_tree::intersect_nodes); }
+    void difference_with(avl_tree&& other, unsigned threads = 0) { combine(std::move(other), threads, &avl_tree::difference_nodes); }
+
     template <typename F>
     requires std::invocable<F&, const Key&, T&>
     void for_each_inorder(F f) {
-      inorder_node(root_.get(), f);
+      inorder_node(*this, f);
     }
     template <typename F>
     requires std::invocable<F&, const Key&, const T&>
     void for_each_inorder(F f) const {
-      inorder_node(root_.get(), f);
+      inorder_node(*this, f);
+    }
+
+    [[nodiscard]] iterator begin() noexcept { return {this, leftmost(root_)}; }
+    [[nodiscard]] const_iterator begin() const noexcept { return {this, leftmost(root_)}; }
+    [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+    [[nodiscard]] iterator end() noexcept { return {this, nil}; }
+    [[nodiscard]] const_iterator end() const noexcept { return {this, nil}; }
+    [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+    [[nodiscard]] reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    [[nodiscard]] const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+    [[nodiscard]] reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    [[nodiscard]] const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+    [[nodiscard]] iterator lower_bound(const Key& key) noexcept { return {this, bound<false>(key)}; }
+    [[nodiscard]] const_iterator lower_bound(const Key& key) const noexcept { return {this, bound<false>(key)}; }
+    [[nodiscard]] iterator upper_bound(const Key& key) noexcept { return {this, bound<true>(key)}; }
+    [[nodiscard]] const_iterator upper_bound(const Key& key) const noexcept { return {this, bound<true>(key)}; }
+    [[nodiscard]] std::pair<iterator, iterator> equal_range(const Key& key) noexcept { return {lower_bound(key), upper_bound(key)}; }
+    [[nodiscard]] std::pair<const_iterator, const_iterator> equal_range(const Key& key) const noexcept {
+      return {lower_bound(key), upper_bound(key)};
+    }
+
+    // Elements with lo <= key < hi; walking it visits O(log n + k) nodes.
+    [[nodiscard]] std::ranges::subrange<iterator> range(const Key& lo, const Key& hi) noexcept {
+      if (!comp_(lo, hi)) return {end(), end()};
+      return {lower_bound(lo), lower_bound(hi)};
+    }
+    [[nodiscard]] std::ranges::subrange<const_iterator> range(const Key& lo, const Key& hi) const noexcept {
+      if (!comp_(lo, hi)) return {end(), end()};
+      return {lower_bound(lo), lower_bound(hi)};
     }
 
     [[nodiscard]] auto to_vector() const -> std::vector<std::pair<Key, T>> {
@@ -228,4 +788,4 @@ class avl_tree {
       for_each_inorder([&](const Key& k, const T& v){ out.emplace_back(k, v); });
       return out;
     }
-};
\ No newline at end of file
+};
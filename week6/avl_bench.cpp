@@ -0,0 +1,152 @@
+#include <bits/stdc++.h>
+#include "avl.cpp"
+#include "bplus_tree.cpp"
+#include "persistent_avl.cpp"
+
+using u64 = unsigned long long;
+
+template <class F>
+double millis(F&& f) {
+  const auto t0 = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Inserts, looks up and erases the same keys; lookups are summed so the
+// work cannot be optimized away.
+template <class Map, class Find>
+void run(std::string_view name, const std::vector<u64>& keys, Find find) {
+  Map m;
+  u64 sum = 0;
+  const double ins = millis([&] { for (u64 k : keys) m.insert_or_assign(k, k); });
+  const double fnd = millis([&] { for (u64 k : keys) sum += find(m, k); });
+  const double era = millis([&] { for (u64 k : keys) m.erase(k); });
+  std::cout << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(1)
+            << " insert " << std::setw(8) << ins << " ms  find " << std::setw(8) << fnd
+            << " ms  erase " << std::setw(8) << era << " ms  (" << (sum & 0xff) << ")\n";
+}
+
+// Short range scans through lower_bound/range versus materializing the map,
+// and the same scans along bplus_tree's leaf chain.
+void run_scans(const std::vector<u64>& keys) {
+  avl_tree<u64, u64> m;
+  bplus_tree<u64, u64> b;
+  for (u64 k : keys) m.insert_or_assign(k, k);
+  for (u64 k : keys) b.insert_or_assign(k, k);
+  std::vector<u64> sorted(keys);
+  std::sort(sorted.begin(), sorted.end());
+  const std::size_t scans = 1000, width = 100;
+  std::mt19937_64 rng(7);
+  u64 sum = 0;
+  const double by_range = millis([&] {
+    for (std::size_t i = 0; i < scans; ++i) {
+      const std::size_t at = rng() % (sorted.size() - width);
+      for (auto& [k, v] : m.range(sorted[at], sorted[at + width])) sum += v;
+    }
+  });
+  const double by_leaves = millis([&] {
+    for (std::size_t i = 0; i < scans; ++i) {
+      const std::size_t at = rng() % (sorted.size() - width);
+      for (auto [k, v] : b.range(sorted[at], sorted[at + width])) sum += v;
+    }
+  });
+  const double by_copy = millis([&] {
+    for (std::size_t i = 0; i < scans / 100; ++i) {
+      const std::size_t at = rng() % (sorted.size() - width);
+      for (auto& [k, v] : m.to_vector()) if (k >= sorted[at] && k < sorted[at + width]) sum += v;
+    }
+  }) * 100;
+  std::cout << std::fixed << std::setprecision(1) << scans << " scans of " << width << ": range() " << by_range
+            << " ms, bplus_tree range() " << by_leaves << " ms, to_vector() " << by_copy << " ms (extrapolated)  (" << (sum & 0xff) << ")\n";
+}
+
+// Bulk paths: linear build from sorted input against repeated insertion, and
+// union of two random halves sequentially and across every core.
+void run_bulk(const std::vector<u64>& keys) {
+  std::vector<std::pair<u64, u64>> sorted;
+  for (u64 k : keys) sorted.emplace_back(k, k);
+  std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+  avl_tree<u64, u64> by_insert, by_build;
+  const double ins = millis([&] { for (auto& [k, v] : sorted) by_insert.insert_or_assign(k, v); });
+  const double bld = millis([&] { by_build = avl_tree<u64, u64>::build_from_sorted(sorted); });
+
+  auto halves = [&] {
+    std::pair<avl_tree<u64, u64>, avl_tree<u64, u64>> h;
+    for (std::size_t i = 0; i < keys.size(); ++i) (i % 2 ? h.second : h.first).insert_or_assign(keys[i], keys[i]);
+    return h;
+  };
+  auto [a1, b1] = halves();
+  auto [a0, b0] = halves();
+  const double seq = millis([&] { a1.union_with(std::move(b1), 1); });
+  const double par = millis([&] { a0.union_with(std::move(b0)); });
+  std::cout << std::fixed << std::setprecision(1) << "build " << sorted.size() << ": insert loop " << ins
+            << " ms, build_from_sorted " << bld << " ms\n"
+            << "union " << keys.size() / 2 << " + " << keys.size() / 2 << ": 1 thread " << seq << " ms, "
+            << std::max(1u, std::thread::hardware_concurrency()) << " threads " << par << " ms  ("
+            << (a1.size() == a0.size() ? "ok" : "SIZE MISMATCH") << ")\n";
+}
+
+// Point-in-time views: an O(1) persistent snapshot against copying the
+// mutable tree out, plus the cost of path copying on updates.
+void run_snapshots(const std::vector<u64>& keys) {
+  avl_tree<u64, u64> m;
+  persistent_avl_tree<u64, u64> p;
+  const double ins_m = millis([&] { for (u64 k : keys) m.insert_or_assign(k, k); });
+  const double ins_p = millis([&] { for (u64 k : keys) p.insert_or_assign(k, k); });
+  const std::size_t views = 10;
+  u64 sum = 0;
+  const double by_copy = millis([&] { for (std::size_t i = 0; i < views; ++i) sum += m.to_vector().size(); });
+  const double by_snap = millis([&] { for (std::size_t i = 0; i < views; ++i) sum += p.snapshot().size(); });
+  std::cout << std::fixed << std::setprecision(1) << "insert " << keys.size() << ": avl_tree " << ins_m
+            << " ms, persistent " << ins_p << " ms\n"
+            << views << " views: to_vector() " << by_copy << " ms, snapshot() " << std::setprecision(4) << by_snap
+            << " ms  (" << (sum & 0xff) << ")\n";
+}
+
+// Cold start from disk: rebuilding by n inserts against load() of a saved
+// snapshot, and lookups on the mapped file against the live tree.
+void run_files(const std::vector<u64>& keys) {
+  const std::string path = (std::filesystem::temp_directory_path() / "avl_bench.snap").string();
+  avl_tree<u64, u64> m;
+  for (u64 k : keys) m.insert_or_assign(k, k);
+  const double save = millis([&] { m.save(path); });
+  avl_tree<u64, u64> by_insert, by_load;
+  const double ins = millis([&] { for (u64 k : keys) by_insert.insert_or_assign(k, k); });
+  const double load = millis([&] { by_load = avl_tree<u64, u64>::load(path); });
+  u64 sum = 0;
+  std::optional<flat_snapshot<u64, u64>> file;
+  const double open = millis([&] { file.emplace(path); });
+  const double fnd_file = millis([&] { for (u64 k : keys) sum += *file->find(k); });
+  const double fnd_tree = millis([&] { for (u64 k : keys) sum += *m.find(k); });
+  std::filesystem::remove(path);
+  std::cout << std::fixed << std::setprecision(1) << "file " << m.size() << ": save " << save << " ms, insert loop "
+            << ins << " ms, load " << load << " ms, map " << std::setprecision(3) << open << " ms\n"
+            << std::setprecision(1) << "find: mapped file " << fnd_file << " ms, avl_tree " << fnd_tree << " ms  ("
+            << (by_load.size() == by_insert.size() ? "ok" : "SIZE MISMATCH") << ", " << (sum & 0xff) << ")\n";
+}
+
+int main(int argc, char** argv) {
+  std::ios::sync_with_stdio(false);
+  std::cin.tie(nullptr);
+  std::cout.tie(nullptr);
+
+  const std::size_t n = argc > 1 ? std::stoull(argv[1]) : 1'000'000;
+  std::mt19937_64 rng(n);
+  std::vector<u64> random(n), sorted(n);
+  for (auto& k : random) k = rng();
+  std::iota(sorted.begin(), sorted.end(), 0);
+
+  for (auto [label, keys] : {std::pair{"random", &random}, std::pair{"sorted", &sorted}}) {
+    std::cout << label << " keys, n = " << n << '\n';
+    run<avl_tree<u64, u64>>("avl_tree", *keys, [](auto& m, u64 k) { return *m.find(k); });
+    run<bplus_tree<u64, u64>>("bplus_tree", *keys, [](auto& m, u64 k) { return *m.find(k); });
+    run<std::map<u64, u64>>("std::map", *keys, [](auto& m, u64 k) { return m.find(k)->second; });
+  }
+  run_scans(random);
+  run_bulk(random);
+  run_snapshots(random);
+  run_files(random);
+  return 0;
+}
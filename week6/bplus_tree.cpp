@@ -0,0 +1,537 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#include "../common/stats.h"
+
+// Number of the n sorted keys that are less than key, i.e. the lower_bound
+// position. Arithmetic keys under std::less are counted branch-free over the
+// node's keys; with AVX2 (-DDSA_NATIVE=ON) integer keys are compared four or
+// eight at a time. Other keys and comparators use binary search.
+template <typename Key, typename Compare>
+inline std::size_t node_lower_bound(const Key* keys, std::size_t n, const Key& key, const Compare& comp) noexcept {
+  if constexpr (std::is_arithmetic_v<Key> && (std::is_same_v<Compare, std::less<Key>> || std::is_same_v<Compare, std::less<>>)) {
+    std::size_t i = 0, c = 0;
+#if defined(__AVX2__)
+    if constexpr (std::is_integral_v<Key> && sizeof(Key) == 8) {
+      // Signed compare only: flipping the sign bit orders unsigned keys.
+      const __m256i flip = _mm256_set1_epi64x(std::is_signed_v<Key> ? 0 : std::numeric_limits<long long>::min());
+      const __m256i k = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<long long>(key)), flip);
+      for (; i + 4 <= n; i += 4) {
+        const __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), flip);
+        c += std::popcount(static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(k, v)))));
+      }
+    } else if constexpr (std::is_integral_v<Key> && sizeof(Key) == 4) {
+      const __m256i flip = _mm256_set1_epi32(std::is_signed_v<Key> ? 0 : std::numeric_limits<int>::min());
+      const __m256i k = _mm256_xor_si256(_mm256_set1_epi32(static_cast<int>(key)), flip);
+      for (; i + 8 <= n; i += 8) {
+        const __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), flip);
+        c += std::popcount(static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(k, v)))));
+      }
+    }
+#endif
+    for (; i < n; ++i) c += keys[i] < key;
+    return c;
+  } else {
+    return static_cast<std::size_t>(std::lower_bound(keys, keys + n, key, comp) - keys);
+  }
+}
+
+// Ordered map with the interface of avl_tree, stored as a B+-tree: every
+// element sits in a leaf, inner nodes hold only separator keys, and leaves
+// are chained for in-order scans. Each node keeps its keys in one array of
+// kNodeKeyBytes (32 u64 keys, four cache lines), so a lookup touches about
+// log32(n) nodes instead of log2(n).
+//
+// Unlike avl_tree, elements move between and within leaves: insert and
+// erase invalidate references, pointers and iterators. Key and T must be
+// default-constructible and movable, since nodes hold plain arrays.
+template <typename Key, typename T, typename Compare = std::less<Key>>
+requires std::strict_weak_order<Compare, Key, Key> && std::default_initializable<Key> && std::movable<Key> &&
+         std::default_initializable<T> && std::movable<T>
+class bplus_tree {
+  private:
+    static constexpr std::size_t kNodeKeyBytes = 256;
+    static constexpr unsigned kCap = static_cast<unsigned>(std::max<std::size_t>(8, kNodeKeyBytes / sizeof(Key)));
+    static constexpr unsigned kMin = kCap / 2;
+    // Inner nodes off the right edge have at least kMin + 1 >= 5 children,
+    // those on it at least 2.
+    static constexpr int kMaxHeight = 32;
+
+    struct Node {};
+
+    // keys[i] >= every key under children[i] and < every key under
+    // children[i + 1]; a key is looked up in children[lower_bound(key)].
+    struct alignas(64) Inner : Node {
+      Key keys[kCap];
+      unsigned count = 0;
+      Node* children[kCap + 1];
+    };
+
+    struct alignas(64) Leaf : Node {
+      Key keys[kCap];
+      unsigned count = 0;
+      Leaf* prev = nullptr;
+      Leaf* next = nullptr;
+      T values[kCap];
+    };
+
+    Node* root_ = nullptr;
+    int height_ = 0;  // inner levels above the leaves
+    Leaf* first_ = nullptr;
+    Leaf* last_ = nullptr;
+    std::size_t size_ = 0;
+    [[no_unique_address]] Compare comp_{};
+    [[no_unique_address]] stats_counter stats_{};
+
+    static Inner* inner(Node* n) noexcept { return static_cast<Inner*>(n); }
+    static Leaf* leaf(Node* n) noexcept { return static_cast<Leaf*>(n); }
+
+    unsigned search(const Key* keys, unsigned n, const Key& key) const noexcept {
+      stats_.visit();
+      return static_cast<unsigned>(node_lower_bound(keys, n, key, comp_));
+    }
+
+    struct path_type {
+      Inner* node[kMaxHeight];
+      unsigned slot[kMaxHeight];
+    };
+
+    // Descends to the leaf key belongs in, recording the inner nodes passed
+    // when path is given. Returns the leaf and key's lower_bound in it.
+    std::pair<Leaf*, unsigned> descend(const Key& key, path_type* path = nullptr) const noexcept {
+      Node* n = root_;
+      for (int d = 0; d < height_; ++d) {
+        Inner* in = inner(n);
+        const unsigned i = search(in->keys, in->count, key);
+        if (path) { path->node[d] = in; path->slot[d] = i; }
+        n = in->children[i];
+      }
+      stats_.depth(static_cast<std::uint64_t>(height_) + 1);
+      Leaf* l = leaf(n);
+      return {l, search(l->keys, l->count, key)};
+    }
+
+    // Leaf and slot of the first key not less than (Upper: greater than) key.
+    template <bool Upper>
+    std::pair<Leaf*, unsigned> bound(const Key& key) const noexcept {
+      if (!root_) return {nullptr, 0};
+      auto [l, i] = descend(key);
+      if (Upper && i < l->count && !comp_(key, l->keys[i])) ++i;
+      if (i == l->count) return {l->next, 0};
+      return {l, i};
+    }
+
+    static void leaf_insert(Leaf* l, unsigned pos, const Key& key, T&& value) {
+      std::move_backward(l->keys + pos, l->keys + l->count, l->keys + l->count + 1);
+      std::move_backward(l->values + pos, l->values + l->count, l->values + l->count + 1);
+      l->keys[pos] = key;
+      l->values[pos] = std::move(value);
+      ++l->count;
+    }
+
+    static void leaf_erase(Leaf* l, unsigned pos) {
+      std::move(l->keys + pos + 1, l->keys + l->count, l->keys + pos);
+      std::move(l->values + pos + 1, l->values + l->count, l->values + pos);
+      --l->count;
+    }
+
+    // Child pos of in was split into children[pos] <= sep < right.
+    static void inner_insert(Inner* in, unsigned pos, Key&& sep, Node* right) {
+      std::move_backward(in->keys + pos, in->keys + in->count, in->keys + in->count + 1);
+      std::move_backward(in->children + pos + 1, in->children + in->count + 1, in->children + in->count + 2);
+      in->keys[pos] = std::move(sep);
+      in->children[pos + 1] = right;
+      ++in->count;
+    }
+
+    // Drops keys[pos] and children[pos + 1].
+    static void inner_erase(Inner* in, unsigned pos) {
+      std::move(in->keys + pos + 1, in->keys + in->count, in->keys + pos);
+      std::move(in->children + pos + 2, in->children + in->count + 1, in->children + pos + 1);
+      --in->count;
+    }
+
+    template <typename N>
+    N* make() {
+      stats_.allocate();
+      return new N;
+    }
+
+    // Either finds key or inserts make() for it. All nodes a split cascade
+    // needs are allocated before anything is modified, so a failed
+    // allocation leaves the tree as it was.
+    template <typename Make>
+    std::pair<T&, bool> find_or_insert(const Key& key, Make&& make_value) {
+      if (!root_) root_ = first_ = last_ = make<Leaf>();
+      path_type path;
+      auto [l, pos] = descend(key, &path);
+      if (pos < l->count && !comp_(key, l->keys[pos])) return {l->values[pos], false};
+
+      T value = make_value();
+      if (l->count < kCap) {
+        leaf_insert(l, pos, key, std::move(value));
+        ++size_;
+        return {l->values[pos], true};
+      }
+
+      int splits = 1;
+      while (splits <= height_ && path.node[height_ - splits]->count == kCap) ++splits;
+      std::unique_ptr<Leaf> new_leaf(make<Leaf>());
+      std::unique_ptr<Inner> spare[kMaxHeight + 1];
+      for (int s = 1; s < splits; ++s) spare[s].reset(make<Inner>());
+      if (splits > height_) spare[0].reset(make<Inner>());
+
+      // Appending past the last key splits off a right node at every level
+      // instead of halving, so ascending inserts leave nearly full nodes: the
+      // new leaf holds only the new key, and each new inner node takes the
+      // last child of the full one beside it, so it keeps one separator and
+      // erase always finds a sibling to borrow from or merge with.
+      const bool append = pos == kCap && !l->next;
+      Leaf* r = new_leaf.release();
+      const unsigned half = append ? kCap : (kCap + 1) / 2;
+      std::move(l->keys + half, l->keys + kCap, r->keys);
+      std::move(l->values + half, l->values + kCap, r->values);
+      r->count = kCap - half;
+      l->count = half;
+      r->prev = l;
+      r->next = l->next;
+      (l->next ? l->next->prev : last_) = r;
+      l->next = r;
+      Leaf* home = pos < half ? l : r;
+      const unsigned at = pos < half ? pos : pos - half;
+      leaf_insert(home, at, key, std::move(value));
+      ++size_;
+
+      Key sep = l->keys[l->count - 1];
+      Node* right = r;
+      for (int d = height_ - 1, s = 1; d >= 0; --d, ++s) {
+        Inner* p = path.node[d];
+        const unsigned i = path.slot[d];
+        if (p->count < kCap) {
+          inner_insert(p, i, std::move(sep), right);
+          return {home->values[at], true};
+        }
+        Inner* q = spare[s].release();
+        if (append) {
+          q->keys[0] = std::move(sep);
+          q->children[0] = p->children[kCap];
+          q->children[1] = right;
+          q->count = 1;
+          sep = std::move(p->keys[kCap - 1]);
+          p->count = kCap - 1;
+          right = q;
+          continue;
+        }
+        const unsigned mid = kCap / 2;
+        std::move(p->keys + mid + 1, p->keys + kCap, q->keys);
+        std::copy(p->children + mid + 1, p->children + kCap + 1, q->children);
+        q->count = kCap - mid - 1;
+        p->count = mid;
+        Key up = std::move(p->keys[mid]);
+        if (i <= mid) inner_insert(p, i, std::move(sep), right);
+        else inner_insert(q, i - mid - 1, std::move(sep), right);
+        sep = std::move(up);
+        right = q;
+      }
+      Inner* top = spare[0].release();
+      top->keys[0] = std::move(sep);
+      top->children[0] = root_;
+      top->children[1] = right;
+      top->count = 1;
+      root_ = top;
+      ++height_;
+      return {home->values[at], true};
+    }
+
+    // Refills leaf child i of p, which fell below kMin, from a sibling that
+    // can spare a key, or else merges it with one.
+    void rebalance_leaf(Inner* p, unsigned i) {
+      Leaf* l = leaf(p->children[i]);
+      if (i > 0) {
+        Leaf* s = leaf(p->children[i - 1]);
+        if (s->count > kMin) {
+          leaf_insert(l, 0, s->keys[s->count - 1], std::move(s->values[s->count - 1]));
+          --s->count;
+          p->keys[i - 1] = s->keys[s->count - 1];
+          return;
+        }
+      }
+      if (i < p->count) {
+        Leaf* s = leaf(p->children[i + 1]);
+        if (s->count > kMin) {
+          leaf_insert(l, l->count, s->keys[0], std::move(s->values[0]));
+          leaf_erase(s, 0);
+          p->keys[i] = l->keys[l->count - 1];
+          return;
+        }
+      }
+      const unsigned j = i > 0 ? i - 1 : i;
+      Leaf* a = leaf(p->children[j]);
+      Leaf* b = leaf(p->children[j + 1]);
+      std::move(b->keys, b->keys + b->count, a->keys + a->count);
+      std::move(b->values, b->values + b->count, a->values + a->count);
+      a->count += b->count;
+      a->next = b->next;
+      (b->next ? b->next->prev : last_) = a;
+      inner_erase(p, j);
+      delete b;
+    }
+
+    // As rebalance_leaf for inner child i of p; separators rotate through p.
+    void rebalance_inner(Inner* p, unsigned i) {
+      Inner* n = inner(p->children[i]);
+      if (i > 0) {
+        Inner* s = inner(p->children[i - 1]);
+        if (s->count > kMin) {
+          std::move_backward(n->keys, n->keys + n->count, n->keys + n->count + 1);
+          std::move_backward(n->children, n->children + n->count + 1, n->children + n->count + 2);
+          n->keys[0] = std::move(p->keys[i - 1]);
+          n->children[0] = s->children[s->count];
+          ++n->count;
+          p->keys[i - 1] = std::move(s->keys[s->count - 1]);
+          --s->count;
+          return;
+        }
+      }
+      if (i < p->count) {
+        Inner* s = inner(p->children[i + 1]);
+        if (s->count > kMin) {
+          n->keys[n->count] = std::move(p->keys[i]);
+          n->children[n->count + 1] = s->children[0];
+          ++n->count;
+          p->keys[i] = std::move(s->keys[0]);
+          std::move(s->keys + 1, s->keys + s->count, s->keys);
+          std::move(s->children + 1, s->children + s->count + 1, s->children);
+          --s->count;
+          return;
+        }
+      }
+      const unsigned j = i > 0 ? i - 1 : i;
+      Inner* a = inner(p->children[j]);
+      Inner* b = inner(p->children[j + 1]);
+      a->keys[a->count] = std::move(p->keys[j]);
+      std::move(b->keys, b->keys + b->count, a->keys + a->count + 1);
+      std::copy(b->children, b->children + b->count + 1, a->children + a->count + 1);
+      a->count += 1 + b->count;
+      inner_erase(p, j);
+      delete b;
+    }
+
+    void destroy(Node* n, int level) noexcept {
+      if (level < height_) {
+        Inner* in = inner(n);
+        for (unsigned i = 0; i <= in->count; ++i) destroy(in->children[i], level + 1);
+        delete in;
+      } else {
+        delete leaf(n);
+      }
+    }
+
+    template <bool Const>
+    class basic_iterator {
+        using tree_ptr = std::conditional_t<Const, const bplus_tree*, bplus_tree*>;
+        tree_ptr tree_ = nullptr;
+        Leaf* leaf_ = nullptr;
+        unsigned i_ = 0;
+        friend class bplus_tree;
+        basic_iterator(tree_ptr t, Leaf* l, unsigned i) noexcept : tree_(t), leaf_(l), i_(i) {}
+
+      public:
+        // Keys and values live in separate arrays, so elements are read as
+        // a pair of references rather than through a stored pair.
+        using reference = std::pair<const Key&, std::conditional_t<Const, const T&, T&>>;
+        using value_type = reference;
+        using iterator_category = std::bidirectional_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+
+        struct pointer {
+          reference r;
+          const reference* operator->() const noexcept { return &r; }
+        };
+
+        basic_iterator() = default;
+        template <bool C = Const> requires C
+        basic_iterator(const basic_iterator<false>& o) noexcept : tree_(o.tree_), leaf_(o.leaf_), i_(o.i_) {}
+
+        reference operator*() const noexcept { return {leaf_->keys[i_], leaf_->values[i_]}; }
+        pointer operator->() const noexcept { return {**this}; }
+        basic_iterator& operator++() noexcept {
+          if (++i_ == leaf_->count) { leaf_ = leaf_->next; i_ = 0; }
+          return *this;
+        }
+        basic_iterator operator++(int) noexcept { auto t = *this; ++*this; return t; }
+        // Decrementing end() yields the last element.
+        basic_iterator& operator--() noexcept {
+          if (!leaf_) { leaf_ = tree_->last_; i_ = leaf_->count; }
+          else if (i_ == 0) { leaf_ = leaf_->prev; i_ = leaf_->count; }
+          --i_;
+          return *this;
+        }
+        basic_iterator operator--(int) noexcept { auto t = *this; --*this; return t; }
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b) noexcept {
+          return a.leaf_ == b.leaf_ && a.i_ == b.i_;
+        }
+    };
+
+  public:
+    using key_type = Key;
+    using mapped_type = T;
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    bplus_tree() = default;
+    explicit bplus_tree(Compare comp) : comp_(std::move(comp)) {}
+
+    bplus_tree(std::initializer_list<std::pair<Key, T>> init, Compare comp = {}) : comp_(std::move(comp)) {
+      for (auto&& p : init) insert_or_assign(p.first, p.second);
+    }
+
+    bplus_tree(bplus_tree&& o) noexcept
+      : root_(std::exchange(o.root_, nullptr)), height_(std::exchange(o.height_, 0)),
+        first_(std::exchange(o.first_, nullptr)), last_(std::exchange(o.last_, nullptr)),
+        size_(std::exchange(o.size_, 0)), comp_(std::move(o.comp_)) {}
+    bplus_tree& operator=(bplus_tree&& o) noexcept {
+      if (this != &o) {
+        clear();
+        swap(o);
+      }
+      return *this;
+    }
+    bplus_tree(const bplus_tree&) = delete;
+    bplus_tree& operator=(const bplus_tree&) = delete;
+    ~bplus_tree() { clear(); }
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t { return size_; }
+    [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+    [[nodiscard]] int height() const noexcept { return root_ ? height_ + 1 : 0; }
+
+    auto insert_or_assign(const Key& key, T value) -> std::pair<T&, bool> {
+      auto r = find_or_insert(key, [&] { return std::move(value); });
+      if (!r.second) r.first = std::move(value);
+      return r;
+    }
+
+    template <typename... Args>
+    requires std::constructible_from<T, Args...>
+    auto emplace(const Key& key, Args&&... args) -> std::pair<T&, bool> {
+      return find_or_insert(key, [&] { return T(std::forward<Args>(args)...); });
+    }
+
+    [[nodiscard]] T* find(const Key& key) noexcept {
+      return const_cast<T*>(std::as_const(*this).find(key));
+    }
+    [[nodiscard]] const T* find(const Key& key) const noexcept {
+      if (!root_) return nullptr;
+      auto [l, i] = descend(key);
+      return i < l->count && !comp_(key, l->keys[i]) ? &l->values[i] : nullptr;
+    }
+
+    [[nodiscard]] bool contains(const Key& key) const noexcept { return find(key) != nullptr; }
+
+    bool erase(const Key& key) {
+      if (!root_) return false;
+      path_type path;
+      auto [l, pos] = descend(key, &path);
+      if (pos == l->count || comp_(key, l->keys[pos])) return false;
+      leaf_erase(l, pos);
+      --size_;
+      for (int d = height_ - 1; d >= 0; --d) {
+        Inner* p = path.node[d];
+        const unsigned i = path.slot[d];
+        if (d == height_ - 1) {
+          if (leaf(p->children[i])->count >= kMin) break;
+          rebalance_leaf(p, i);
+        } else {
+          if (inner(p->children[i])->count >= kMin) break;
+          rebalance_inner(p, i);
+        }
+      }
+      if (height_ > 0 && inner(root_)->count == 0) {
+        Inner* old = inner(root_);
+        root_ = old->children[0];
+        --height_;
+        delete old;
+      } else if (height_ == 0 && leaf(root_)->count == 0) {
+        delete leaf(root_);
+        root_ = first_ = last_ = nullptr;
+      }
+      return true;
+    }
+
+    void clear() noexcept {
+      if (root_) destroy(root_, 0);
+      root_ = first_ = last_ = nullptr;
+      height_ = 0;
+      size_ = 0;
+    }
+
+    // Nodes visited, allocations and depth; all zero unless built with DSA_STATS.
+    [[nodiscard]] container_stats stats() const noexcept { return stats_.get(); }
+    void reset_stats() noexcept { stats_.reset(); }
+
+    void swap(bplus_tree& o) noexcept {
+      std::swap(root_, o.root_);
+      std::swap(height_, o.height_);
+      std::swap(first_, o.first_);
+      std::swap(last_, o.last_);
+      std::swap(size_, o.size_);
+      std::swap(comp_, o.comp_);
+    }
+
+    // Walks the leaf chain; no tree descent after the first leaf.
+    template <typename F>
+    requires std::invocable<F&, const Key&, T&>
+    void for_each_inorder(F f) {
+      for (Leaf* l = first_; l; l = l->next)
+        for (unsigned i = 0; i < l->count; ++i) std::invoke(f, std::as_const(l->keys[i]), l->values[i]);
+    }
+    template <typename F>
+    requires std::invocable<F&, const Key&, const T&>
+    void for_each_inorder(F f) const {
+      for (const Leaf* l = first_; l; l = l->next)
+        for (unsigned i = 0; i < l->count; ++i) std::invoke(f, l->keys[i], l->values[i]);
+    }
+
+    [[nodiscard]] iterator begin() noexcept { return {this, first_, 0}; }
+    [[nodiscard]] const_iterator begin() const noexcept { return {this, first_, 0}; }
+    [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+    [[nodiscard]] iterator end() noexcept { return {this, nullptr, 0}; }
+    [[nodiscard]] const_iterator end() const noexcept { return {this, nullptr, 0}; }
+    [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+    [[nodiscard]] iterator lower_bound(const Key& key) noexcept { auto [l, i] = bound<false>(key); return {this, l, i}; }
+    [[nodiscard]] const_iterator lower_bound(const Key& key) const noexcept { auto [l, i] = bound<false>(key); return {this, l, i}; }
+    [[nodiscard]] iterator upper_bound(const Key& key) noexcept { auto [l, i] = bound<true>(key); return {this, l, i}; }
+    [[nodiscard]] const_iterator upper_bound(const Key& key) const noexcept { auto [l, i] = bound<true>(key); return {this, l, i}; }
+
+    // Elements with lo <= key < hi: one descent, then a walk along the leaves.
+    [[nodiscard]] std::ranges::subrange<iterator> range(const Key& lo, const Key& hi) noexcept {
+      if (!comp_(lo, hi)) return {end(), end()};
+      return {lower_bound(lo), lower_bound(hi)};
+    }
+    [[nodiscard]] std::ranges::subrange<const_iterator> range(const Key& lo, const Key& hi) const noexcept {
+      if (!comp_(lo, hi)) return {end(), end()};
+      return {lower_bound(lo), lower_bound(hi)};
+    }
+
+    [[nodiscard]] auto to_vector() const -> std::vector<std::pair<Key, T>> {
+      std::vector<std::pair<Key, T>> out;
+      out.reserve(size_);
+      for_each_inorder([&](const Key& k, const T& v) { out.emplace_back(k, v); });
+      return out;
+    }
+};
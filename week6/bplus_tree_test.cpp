@@ -0,0 +1,94 @@
+#include <bits/stdc++.h>
+#include "bplus_tree.cpp"
+
+using u64 = unsigned long long;
+using tree = bplus_tree<u64, u64>;
+using model = std::map<u64, u64>;
+
+// Node capacity for 8-byte keys (kNodeKeyBytes / sizeof(u64)).
+constexpr u64 kCap = 32;
+
+int failures = 0;
+
+void check(bool ok, std::string_view what, u64 step) {
+  if (ok) return;
+  std::cerr << "FAIL: " << what << " at step " << step << '\n';
+  ++failures;
+}
+
+// Full comparison: size, in-order contents, forward and reverse.
+void same(const tree& t, const model& m, std::string_view what, u64 step) {
+  auto eq = [](const auto& a, const auto& b) { return a.first == b.first && a.second == b.second; };
+  check(t.size() == m.size(), what, step);
+  check(std::ranges::equal(t.to_vector(), m, eq), what, step);
+  check(std::ranges::equal(t | std::views::reverse, m | std::views::reverse, eq), what, step);
+}
+
+// Appends 0..n-1, which splits off right-edge nodes at every level, then
+// erases every key in the given order, checking against std::map.
+void append_then_erase(u64 n, bool ascending) {
+  const std::string what = "append " + std::to_string(n) + ", erase " + (ascending ? "ascending" : "descending");
+  tree t;
+  model m;
+  for (u64 k = 0; k < n; ++k) {
+    t.insert_or_assign(k, k * 3);
+    m.insert_or_assign(k, k * 3);
+  }
+  same(t, m, what, 0);
+  for (u64 i = 0; i < n; ++i) {
+    const u64 k = ascending ? i : n - 1 - i;
+    check(t.erase(k), what, i);
+    check(!t.contains(k), what, i);
+    m.erase(k);
+    if (i % 61 == 0 || m.size() < 2 * kCap) same(t, m, what, i);
+  }
+  same(t, m, what, n);
+  check(t.empty() && t.begin() == t.end(), what, n);
+}
+
+// Random inserts and erases over a small key range, with appends mixed in so
+// the right edge keeps being split off while the rest is erased.
+void mixed(u64 steps, u64 seed) {
+  const std::string what = "mixed seed " + std::to_string(seed);
+  std::mt19937_64 rng(seed);
+  tree t;
+  model m;
+  u64 next = 0;
+  for (u64 i = 0; i < steps; ++i) {
+    const unsigned p = rng() % 8;
+    if (p < 3) {
+      const u64 k = next++;
+      t.insert_or_assign(k, i);
+      m.insert_or_assign(k, i);
+    } else if (p < 5) {
+      const u64 k = rng() % (next + 1);
+      t.insert_or_assign(k, i);
+      m.insert_or_assign(k, i);
+    } else {
+      const u64 k = rng() % (next + 1);
+      check(t.erase(k) == (m.erase(k) == 1), what, i);
+    }
+    if (i % 997 == 0) same(t, m, what, i);
+  }
+  same(t, m, what, steps);
+}
+
+int main() {
+  for (u64 n : {kCap * (kCap + 1) + 1, kCap * (kCap + 1) * (kCap + 1) + 1}) {
+    append_then_erase(n, true);
+    append_then_erase(n, false);
+  }
+  {
+    tree t;
+    for (u64 k = 0; k <= kCap * (kCap + 1); ++k) t.insert_or_assign(k, k);
+    check(t.erase(kCap * (kCap + 1)) && t.size() == kCap * (kCap + 1), "erase last after append", 0);
+  }
+  for (u64 seed = 1; seed <= 4; ++seed) mixed(200'000, seed);
+
+  if (failures) {
+    std::cerr << failures << " check(s) failed\n";
+    return 1;
+  }
+  std::cout << "bplus_tree: all checks passed\n";
+  return 0;
+}
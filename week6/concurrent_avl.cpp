@@ -0,0 +1,548 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include "avl.cpp"
+#include "../common/epoch.h"
+
+// Concurrent ordered map: a relaxed-balance AVL tree with optimistic reads,
+// after Bronson, Casper, Chafi and Olukotun, "A Practical Concurrent Binary
+// Search Tree" (PPoPP 2010).
+//
+// Every node carries a version word and a lock. Readers take no locks: they
+// descend hand over hand, reading a child and then re-checking that the
+// parent's version is unchanged, and retry from the parent when it moved. A
+// rotation bumps the version of the node it moves down, the only one whose
+// subtree loses keys. Writers lock just the nodes they link or rotate,
+// parent before child, so updates in different parts of the tree proceed in
+// parallel. Erasing a node with two children leaves it in place as a routing
+// node without a value; rebalancing unlinks routing nodes once they have at
+// most one child, and repairs heights and balance after the update instead
+// of inside it, so the tree is only approximately balanced while writers run.
+//
+// Unlinked nodes and replaced values are freed through common/epoch.h: every
+// operation pins the calling thread, which costs a store to a thread-local
+// record rather than a shared refcount.
+template <typename Key, typename T, KeyComparator<Key> Compare = std::less<Key>>
+class concurrent_avl_map {
+  private:
+    // Version word: bit 0 unlinked, bit 1 shrinking (a rotation is moving keys
+    // out of the node's subtree), the rest counts finished rotations.
+    static constexpr std::uint64_t kUnlinked = 1, kShrinking = 2, kVersionStep = 4;
+    static constexpr int kSpins = 100;
+
+    // Per-node lock: a flag that waits in the kernel after a short spin.
+    class node_lock {
+        std::atomic<bool> held_{false};
+
+      public:
+        void lock() noexcept {
+          for (int i = 0; held_.exchange(true, std::memory_order_acquire); ++i)
+            if (i >= kSpins) held_.wait(true, std::memory_order_relaxed);
+        }
+        void unlock() noexcept {
+          held_.store(false, std::memory_order_release);
+          held_.notify_one();
+        }
+    };
+
+    struct Node;
+
+    // The root holder and the base of every node. A null value marks a
+    // routing node, whose key is not in the map.
+    struct Link {
+      std::atomic<std::uint64_t> version{0};
+      std::atomic<int> height{0};
+      std::atomic<Node*> left{nullptr};
+      std::atomic<Node*> right{nullptr};
+      std::atomic<Link*> parent{nullptr};
+      std::atomic<T*> value{nullptr};
+      node_lock lock;
+
+      Node* child(int dir) const noexcept { return (dir < 0 ? left : right).load(); }
+    };
+
+    struct Node : Link {
+      const Key key;
+      Node(const Key& k, T* v, Link* p) : key(k) {
+        this->height.store(1, std::memory_order_relaxed);
+        this->value.store(v, std::memory_order_relaxed);
+        this->parent.store(p, std::memory_order_relaxed);
+      }
+    };
+
+    // Result of an attempt that may have to be redone from the parent.
+    template <typename R>
+    struct attempt {
+      bool done;
+      R result;
+    };
+
+    static constexpr int kUnlinkRequired = -1, kRebalanceRequired = -2, kNothingRequired = -3;
+
+    Link holder_;  // the root is holder_.right
+    std::atomic<std::size_t> size_{0};
+    [[no_unique_address]] Compare comp_{};
+
+    int cmp(const Key& a, const Key& b) const noexcept { return comp_(a, b) ? -1 : comp_(b, a) ? 1 : 0; }
+    static int height(const Link* n) noexcept { return n ? n->height.load(std::memory_order_relaxed) : 0; }
+    static bool unstable(std::uint64_t v) noexcept { return v & (kUnlinked | kShrinking); }
+
+    // Waits out a rotation at n; the rotating thread holds n's lock.
+    static void wait_until_changed(Link* n, std::uint64_t v) noexcept {
+      if (!(v & kShrinking)) return;
+      for (int i = 0; i < kSpins; ++i)
+        if (n->version.load() != v) return;
+      std::lock_guard lk(n->lock);
+    }
+
+    // Descends from the root with f(node, version) once the root is stable.
+    template <typename R, typename F>
+    R from_root(R empty, F f) const {
+      for (;;) {
+        Node* root = holder_.right.load();
+        if (!root) return empty;
+        const std::uint64_t v = root->version.load();
+        if (unstable(v)) wait_until_changed(root, v);
+        else if (root == holder_.right.load())
+          if (auto r = f(root, v); r.done) return r.result;
+      }
+    }
+
+    // One step of an optimistic descent: reads node's child in dir and
+    // validates it against node's version v. Calls leaf() when there is no
+    // child and down(child, child_version) otherwise; either may ask for a
+    // retry, which is passed up when node itself has changed.
+    template <typename R, typename Leaf, typename Down>
+    static attempt<R> descend(Link* node, int dir, std::uint64_t v, Leaf leaf, Down down) {
+      for (;;) {
+        Node* child = node->child(dir);
+        if (node->version.load() != v) return {false, R{}};
+        if (!child) {
+          auto r = leaf();
+          if (r.done || node->version.load() != v) return r;
+          continue;
+        }
+        const std::uint64_t cv = child->version.load();
+        if (unstable(cv)) {
+          wait_until_changed(child, cv);
+        } else if (child == node->child(dir)) {
+          if (node->version.load() != v) return {false, R{}};
+          if (auto r = down(child, cv); r.done) return r;
+        }
+        if (node->version.load() != v) return {false, R{}};
+      }
+    }
+
+    attempt<T*> attempt_get(const Key& key, Node* node, std::uint64_t v) const {
+      const int c = cmp(key, node->key);
+      if (c == 0) return {true, node->value.load()};
+      return descend<T*>(
+          node, c, v, [] { return attempt<T*>{true, nullptr}; },
+          [&](Node* child, std::uint64_t cv) { return attempt_get(key, child, cv); });
+    }
+
+    // Value for key, or null; the caller must be pinned.
+    T* get(const Key& key) const {
+      return from_root<T*>(nullptr, [&](Node* root, std::uint64_t v) { return attempt_get(key, root, v); });
+    }
+
+    // Node with the least key above *key (or equal, when inclusive; the least
+    // key when key is null). It may have become a routing node by the time
+    // the caller looks at it.
+    attempt<Node*> attempt_next(const Key* key, bool inclusive, Node* node, std::uint64_t v) const {
+      const int c = key ? cmp(*key, node->key) : -1;
+      if (c == 0 && inclusive) return {true, node};
+      const int dir = c < 0 ? -1 : 1;
+      auto r = descend<Node*>(
+          node, dir, v, [] { return attempt<Node*>{true, nullptr}; },
+          [&](Node* child, std::uint64_t cv) { return attempt_next(key, inclusive, child, cv); });
+      if (r.done && !r.result && dir < 0) r.result = node;
+      return r;
+    }
+
+    Node* next(const Key* key, bool inclusive) const {
+      return from_root<Node*>(nullptr, [&](Node* root, std::uint64_t v) { return attempt_next(key, inclusive, root, v); });
+    }
+
+    // Sets key's value to v, or erases key when v is null, and returns the
+    // previous value. Takes ownership of v on return, not on a throw.
+    T* update(const Key& key, T* v) {
+      for (;;) {
+        Node* root = holder_.right.load();
+        if (!root) {
+          if (!v) return nullptr;
+          std::lock_guard lk(holder_.lock);
+          if (holder_.right.load()) continue;
+          holder_.right.store(new Node(key, v, &holder_));
+          size_.fetch_add(1, std::memory_order_relaxed);
+          return nullptr;
+        }
+        const std::uint64_t ver = root->version.load();
+        if (unstable(ver)) wait_until_changed(root, ver);
+        else if (root == holder_.right.load())
+          if (auto r = attempt_update(key, v, &holder_, root, ver); r.done) return r.result;
+      }
+    }
+
+    attempt<T*> attempt_update(const Key& key, T* v, Link* parent, Node* node, std::uint64_t ver) {
+      const int c = cmp(key, node->key);
+      if (c == 0) return attempt_node_update(v, parent, node);
+      return descend<T*>(
+          node, c, ver,
+          [&]() -> attempt<T*> {
+            if (!v) return {true, nullptr};
+            Link* damaged;
+            {
+              std::lock_guard lk(node->lock);
+              if (node->version.load() != ver || node->child(c)) return {false, nullptr};
+              Node* fresh = new Node(key, v, node);
+              (c < 0 ? node->left : node->right).store(fresh);
+              size_.fetch_add(1, std::memory_order_relaxed);
+              damaged = fix_height_locked(node);
+            }
+            fix_height_and_rebalance(damaged);
+            return {true, nullptr};
+          },
+          [&](Node* child, std::uint64_t cv) { return attempt_update(key, v, node, child, cv); });
+    }
+
+    attempt<T*> attempt_node_update(T* v, Link* parent, Node* node) {
+      if (!v) {
+        if (!node->value.load()) return {true, nullptr};
+        if (!node->left.load() || !node->right.load()) {
+          T* prev;
+          Link* damaged;
+          {
+            std::lock_guard lp(parent->lock);
+            if ((parent->version.load() & kUnlinked) || node->parent.load() != parent) return {false, nullptr};
+            {
+              std::lock_guard ln(node->lock);
+              prev = node->value.load();
+              if (!prev) return {true, nullptr};
+              if (!unlink_locked(parent, node)) return {false, nullptr};
+            }
+            damaged = fix_height_locked(parent);
+          }
+          size_.fetch_sub(1, std::memory_order_relaxed);
+          fix_height_and_rebalance(damaged);
+          return {true, prev};
+        }
+      }
+      std::lock_guard ln(node->lock);
+      if (node->version.load() & kUnlinked) return {false, nullptr};
+      T* prev = node->value.load();
+      if (!v && !prev) return {true, nullptr};
+      // It may have lost a child since; splice it out instead.
+      if (!v && (!node->left.load() || !node->right.load())) return {false, nullptr};
+      node->value.store(v);
+      if (!prev) size_.fetch_add(1, std::memory_order_relaxed);
+      else if (!v) size_.fetch_sub(1, std::memory_order_relaxed);
+      return {true, prev};
+    }
+
+    // Splices out node, which has at most one child; both locks are held.
+    bool unlink_locked(Link* parent, Node* node) {
+      Node* pl = parent->left.load();
+      Node* pr = parent->right.load();
+      if (pl != node && pr != node) return false;
+      Node* l = node->left.load();
+      Node* r = node->right.load();
+      if (l && r) return false;
+      Node* splice = l ? l : r;
+      (pl == node ? parent->left : parent->right).store(splice);
+      if (splice) splice->parent.store(parent);
+      node->version.store(kUnlinked);
+      node->value.store(nullptr);
+      epoch_retire(node);
+      return true;
+    }
+
+    int node_condition(Link* n) const noexcept {
+      Node* l = n->left.load();
+      Node* r = n->right.load();
+      if ((!l || !r) && !n->value.load()) return kUnlinkRequired;
+      const int h = height(n), hl = height(l), hr = height(r);
+      const int repl = 1 + std::max(hl, hr), bal = hl - hr;
+      if (bal < -1 || bal > 1) return kRebalanceRequired;
+      return h != repl ? repl : kNothingRequired;
+    }
+
+    // Repairs n's height with n locked; returns the next damaged node.
+    Link* fix_height_locked(Link* n) noexcept {
+      const int c = node_condition(n);
+      if (c == kRebalanceRequired || c == kUnlinkRequired) return n;
+      if (c == kNothingRequired) return nullptr;
+      n->height.store(c, std::memory_order_relaxed);
+      return n->parent.load();
+    }
+
+    // Walks damage up toward the root: height fixes need only the node,
+    // rotations and unlinks also its parent.
+    void fix_height_and_rebalance(Link* n) {
+      while (n && n->parent.load()) {
+        const int c = node_condition(n);
+        if (c == kNothingRequired || (n->version.load() & kUnlinked)) return;
+        if (c != kUnlinkRequired && c != kRebalanceRequired) {
+          std::lock_guard lk(n->lock);
+          n = fix_height_locked(n);
+        } else {
+          Link* p = n->parent.load();
+          std::lock_guard lp(p->lock);
+          if (!(p->version.load() & kUnlinked) && n->parent.load() == p) {
+            std::lock_guard ln(n->lock);
+            n = rebalance_locked(p, static_cast<Node*>(n));
+          }
+        }
+      }
+    }
+
+    Link* rebalance_locked(Link* p, Node* n) {
+      Node* l = n->left.load();
+      Node* r = n->right.load();
+      if ((!l || !r) && !n->value.load()) return unlink_locked(p, n) ? fix_height_locked(p) : n;
+      const int h = height(n), hl = height(l), hr = height(r);
+      const int repl = 1 + std::max(hl, hr), bal = hl - hr;
+      if (bal > 1) return rebalance_to_right(p, n, l, hr);
+      if (bal < -1) return rebalance_to_left(p, n, r, hl);
+      if (repl != h) {
+        n->height.store(repl, std::memory_order_relaxed);
+        return fix_height_locked(p);
+      }
+      return nullptr;
+    }
+
+    // n's left subtree is too tall: rotate right, first rotating l left when
+    // its inner grandchild is the taller one.
+    Link* rebalance_to_right(Link* p, Node* n, Node* l, int hr0) {
+      std::lock_guard ll(l->lock);
+      if (height(l) - hr0 <= 1) return n;
+      Node* lr = l->right.load();
+      const int hll0 = height(l->left.load()), hlr0 = height(lr);
+      if (hll0 >= hlr0) return rotate_right(p, n, l, hr0, hll0, lr, hlr0);
+      {
+        std::lock_guard llr(lr->lock);
+        const int hlr = height(lr);
+        if (hll0 >= hlr) return rotate_right(p, n, l, hr0, hll0, lr, hlr);
+        const int hlrl = height(lr->left.load()), b = hll0 - hlrl;
+        if (b >= -1 && b <= 1 && !((hll0 == 0 || hlrl == 0) && !l->value.load()))
+          return rotate_right_over_left(p, n, l, hr0, hll0, lr, hlrl);
+      }
+      // A double rotation would leave l damaged; fix l on its own first.
+      return rebalance_to_left(n, l, lr, hll0);
+    }
+
+    Link* rebalance_to_left(Link* p, Node* n, Node* r, int hl0) {
+      std::lock_guard lr_(r->lock);
+      if (hl0 - height(r) >= -1) return n;
+      Node* rl = r->left.load();
+      const int hrl0 = height(rl), hrr0 = height(r->right.load());
+      if (hrr0 >= hrl0) return rotate_left(p, n, hl0, r, rl, hrl0, hrr0);
+      {
+        std::lock_guard lrl(rl->lock);
+        const int hrl = height(rl);
+        if (hrr0 >= hrl) return rotate_left(p, n, hl0, r, rl, hrl, hrr0);
+        const int hrlr = height(rl->right.load()), b = hrr0 - hrlr;
+        if (b >= -1 && b <= 1 && !((hrr0 == 0 || hrlr == 0) && !r->value.load()))
+          return rotate_left_over_right(p, n, hl0, r, rl, hrr0, hrlr);
+      }
+      return rebalance_to_right(n, r, rl, hrr0);
+    }
+
+    static void replace_child(Link* p, Node* old, Node* now) {
+      (p->left.load() == old ? p->left : p->right).store(now);
+      now->parent.store(p);
+    }
+
+    // p, n and l are locked. n moves down and loses keys, so it is marked
+    // shrinking for the duration; l only gains keys and keeps its version.
+    Link* rotate_right(Link* p, Node* n, Node* l, int hr, int hll, Node* lr, int hlr) {
+      const std::uint64_t v = n->version.load();
+      n->version.store(v | kShrinking);
+      n->left.store(lr);
+      if (lr) lr->parent.store(n);
+      l->right.store(n);
+      n->parent.store(l);
+      replace_child(p, n, l);
+      const int hn = 1 + std::max(hlr, hr);
+      n->height.store(hn, std::memory_order_relaxed);
+      l->height.store(1 + std::max(hll, hn), std::memory_order_relaxed);
+      n->version.store(v + kVersionStep);
+
+      // Fix what the locks held allow, deepest damage first.
+      if (hlr - hr < -1 || hlr - hr > 1) return n;
+      if ((!lr || hr == 0) && !n->value.load()) return n;
+      if (hll - hn < -1 || hll - hn > 1) return l;
+      if (hll == 0 && !l->value.load()) return l;
+      return fix_height_locked(p);
+    }
+
+    Link* rotate_left(Link* p, Node* n, int hl, Node* r, Node* rl, int hrl, int hrr) {
+      const std::uint64_t v = n->version.load();
+      n->version.store(v | kShrinking);
+      n->right.store(rl);
+      if (rl) rl->parent.store(n);
+      r->left.store(n);
+      n->parent.store(r);
+      replace_child(p, n, r);
+      const int hn = 1 + std::max(hl, hrl);
+      n->height.store(hn, std::memory_order_relaxed);
+      r->height.store(1 + std::max(hn, hrr), std::memory_order_relaxed);
+      n->version.store(v + kVersionStep);
+
+      if (hrl - hl < -1 || hrl - hl > 1) return n;
+      if ((!rl || hl == 0) && !n->value.load()) return n;
+      if (hrr - hn < -1 || hrr - hn > 1) return r;
+      if (hrr == 0 && !r->value.load()) return r;
+      return fix_height_locked(p);
+    }
+
+    // p, n, l and lr are locked; lr rises two levels, n and l both shrink.
+    Link* rotate_right_over_left(Link* p, Node* n, Node* l, int hr, int hll, Node* lr, int hlrl) {
+      const std::uint64_t nv = n->version.load(), lv = l->version.load();
+      Node* lrl = lr->left.load();
+      Node* lrr = lr->right.load();
+      const int hlrr = height(lrr);
+      n->version.store(nv | kShrinking);
+      l->version.store(lv | kShrinking);
+      n->left.store(lrr);
+      if (lrr) lrr->parent.store(n);
+      l->right.store(lrl);
+      if (lrl) lrl->parent.store(l);
+      lr->left.store(l);
+      l->parent.store(lr);
+      lr->right.store(n);
+      n->parent.store(lr);
+      replace_child(p, n, lr);
+      const int hn = 1 + std::max(hlrr, hr), hlnew = 1 + std::max(hll, hlrl);
+      n->height.store(hn, std::memory_order_relaxed);
+      l->height.store(hlnew, std::memory_order_relaxed);
+      lr->height.store(1 + std::max(hlnew, hn), std::memory_order_relaxed);
+      n->version.store(nv + kVersionStep);
+      l->version.store(lv + kVersionStep);
+
+      if (hlrr - hr < -1 || hlrr - hr > 1) return n;
+      if ((!lrr || hr == 0) && !n->value.load()) return n;
+      if (hlnew - hn < -1 || hlnew - hn > 1) return lr;
+      return fix_height_locked(p);
+    }
+
+    Link* rotate_left_over_right(Link* p, Node* n, int hl, Node* r, Node* rl, int hrr, int hrlr) {
+      const std::uint64_t nv = n->version.load(), rv = r->version.load();
+      Node* rll = rl->left.load();
+      Node* rlr = rl->right.load();
+      const int hrll = height(rll);
+      n->version.store(nv | kShrinking);
+      r->version.store(rv | kShrinking);
+      n->right.store(rll);
+      if (rll) rll->parent.store(n);
+      r->left.store(rlr);
+      if (rlr) rlr->parent.store(r);
+      rl->right.store(r);
+      r->parent.store(rl);
+      rl->left.store(n);
+      n->parent.store(rl);
+      replace_child(p, n, rl);
+      const int hn = 1 + std::max(hl, hrll), hrnew = 1 + std::max(hrlr, hrr);
+      n->height.store(hn, std::memory_order_relaxed);
+      r->height.store(hrnew, std::memory_order_relaxed);
+      rl->height.store(1 + std::max(hn, hrnew), std::memory_order_relaxed);
+      n->version.store(nv + kVersionStep);
+      r->version.store(rv + kVersionStep);
+
+      if (hrll - hl < -1 || hrll - hl > 1) return n;
+      if ((!rll || hl == 0) && !n->value.load()) return n;
+      if (hrnew - hn < -1 || hrnew - hn > 1) return rl;
+      return fix_height_locked(p);
+    }
+
+  public:
+    using key_type = Key;
+    using mapped_type = T;
+
+    concurrent_avl_map() = default;
+    explicit concurrent_avl_map(Compare comp) : comp_(std::move(comp)) {}
+    concurrent_avl_map(const concurrent_avl_map&) = delete;
+    concurrent_avl_map& operator=(const concurrent_avl_map&) = delete;
+
+    // Not concurrent with any other call.
+    ~concurrent_avl_map() {
+      std::vector<Node*> stack;
+      if (Node* root = holder_.right.load()) stack.push_back(root);
+      while (!stack.empty()) {
+        Node* n = stack.back();
+        stack.pop_back();
+        if (Node* l = n->left.load()) stack.push_back(l);
+        if (Node* r = n->right.load()) stack.push_back(r);
+        delete n->value.load();
+        delete n;
+      }
+    }
+
+    // Exact when no update is in flight.
+    [[nodiscard]] std::size_t size() const noexcept { return size_.load(std::memory_order_relaxed); }
+    [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+    [[nodiscard]] std::optional<T> find(const Key& key) const {
+      epoch_guard g;
+      if (const T* v = get(key)) return *v;
+      return std::nullopt;
+    }
+
+    [[nodiscard]] bool contains(const Key& key) const {
+      epoch_guard g;
+      return get(key) != nullptr;
+    }
+
+    // Calls f on the value in place; returns false when key is absent. The
+    // value is never modified in place, but may be replaced meanwhile.
+    template <typename F>
+    requires std::invocable<F&, const T&>
+    bool read(const Key& key, F f) const {
+      epoch_guard g;
+      const T* v = get(key);
+      if (!v) return false;
+      std::invoke(f, *v);
+      return true;
+    }
+
+    // Visits lo <= key < hi in order, one O(log n) descent per key. Weakly
+    // consistent: keys present throughout are visited, keys inserted or
+    // erased meanwhile may or may not be. Memory retired by concurrent
+    // writers is held until the walk ends.
+    template <typename F>
+    requires std::invocable<F&, const Key&, const T&>
+    void for_each_in_range(const Key& lo, const Key& hi, F f) const {
+      epoch_guard g;
+      for (Node* n = next(&lo, true); n && comp_(n->key, hi); n = next(&n->key, false))
+        if (const T* v = n->value.load()) std::invoke(f, n->key, *v);
+    }
+
+    // Returns true when key was inserted, false when its value was replaced.
+    bool insert_or_assign(const Key& key, T value) {
+      auto fresh = std::make_unique<T>(std::move(value));
+      epoch_guard g;
+      T* prev = update(key, fresh.get());
+      fresh.release();
+      if (prev) epoch_retire(prev);
+      return !prev;
+    }
+
+    bool erase(const Key& key) {
+      epoch_guard g;
+      T* prev = update(key, nullptr);
+      if (prev) epoch_retire(prev);
+      return prev != nullptr;
+    }
+
+    // Erases the keys one by one; keys inserted meanwhile may survive.
+    void clear() {
+      epoch_guard g;
+      for (Node* n = next(nullptr, true); n; n = next(&n->key, false)) erase(n->key);
+    }
+};
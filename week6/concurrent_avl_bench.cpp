@@ -0,0 +1,64 @@
+#include <bits/stdc++.h>
+#include "concurrent_avl.cpp"
+
+using u64 = unsigned long long;
+
+// Baseline: what callers do today, one avl_tree behind one mutex.
+struct LockedMap {
+  mutable std::mutex mu;
+  avl_tree<u64, u64> map;
+  void insert_or_assign(u64 k, u64 v) { std::lock_guard lk(mu); map.insert_or_assign(k, v); }
+  void erase(u64 k) { std::lock_guard lk(mu); map.erase(k); }
+  bool contains(u64 k) const { std::lock_guard lk(mu); return map.contains(k); }
+};
+
+// Each thread runs a random mix over keys in [0, range): write_pct percent
+// updates (half inserts, half erases), the rest lookups.
+template <class M>
+double throughput(unsigned threads, std::size_t range, std::size_t ops, unsigned write_pct) {
+  M m;
+  for (std::size_t k = 0; k < range; k += 2) m.insert_or_assign(k, k);
+  std::atomic<bool> go{false};
+  std::atomic<u64> hits{0};
+  std::vector<std::jthread> pool;
+  for (unsigned t = 0; t < threads; ++t) pool.emplace_back([&, t] {
+    std::mt19937_64 r(t + 2);
+    u64 h = 0;
+    while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+    for (std::size_t i = 0; i < ops / threads; ++i) {
+      const u64 k = r() % range;
+      const unsigned p = r() % 100;
+      if (p >= write_pct) h += m.contains(k);
+      else if (p & 1) m.erase(k);
+      else m.insert_or_assign(k, k);
+    }
+    hits.fetch_add(h, std::memory_order_relaxed);
+  });
+  const auto t0 = std::chrono::steady_clock::now();
+  go.store(true, std::memory_order_release);
+  pool.clear();
+  return ops / std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+  std::ios::sync_with_stdio(false);
+  std::cin.tie(nullptr);
+  std::cout.tie(nullptr);
+
+  const unsigned max_threads = argc > 1 ? std::stoul(argv[1]) : 64;
+  const std::size_t range = argc > 2 ? std::stoull(argv[2]) : 1 << 20;
+  const std::size_t ops = 1 << 21;
+
+  // Past this many threads the rows measure oversubscription, not scaling.
+  std::cout << "hardware threads: " << std::thread::hardware_concurrency() << '\n';
+  for (unsigned write_pct : {0u, 1u, 10u, 50u}) {
+    std::cout << write_pct << "% writes\nthreads  locked Mops/s  concurrent Mops/s\n";
+    for (unsigned t = 1; t <= max_threads; t *= 2) {
+      const double base = throughput<LockedMap>(t, range, ops, write_pct);
+      const double conc = throughput<concurrent_avl_map<u64, u64>>(t, range, ops, write_pct);
+      std::cout << std::setw(7) << t << std::fixed << std::setprecision(2)
+                << std::setw(15) << base / 1e6 << std::setw(19) << conc / 1e6 << '\n';
+    }
+  }
+  return 0;
+}
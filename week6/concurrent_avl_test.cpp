@@ -0,0 +1,110 @@
+#include <bits/stdc++.h>
+#include "concurrent_avl.cpp"
+
+using u64 = unsigned long long;
+using cmap = concurrent_avl_map<u64, u64>;
+
+std::atomic<int> failures{0};
+
+void check(bool ok, std::string_view what) {
+  if (ok) return;
+  static std::mutex mu;
+  std::lock_guard lk(mu);
+  std::cerr << "FAIL: " << what << '\n';
+  ++failures;
+}
+
+// Single-threaded operations against std::map, including routing nodes left
+// by erasing keys with two children and range walks over them.
+void sequential(u64 steps, u64 seed) {
+  std::mt19937_64 rng(seed);
+  cmap m;
+  std::map<u64, u64> ref;
+  for (u64 i = 0; i < steps; ++i) {
+    const u64 k = rng() % 2'000;
+    switch (rng() % 4) {
+      case 0:
+      case 1: check(m.insert_or_assign(k, i) == ref.insert_or_assign(k, i).second, "sequential insert"); break;
+      case 2: check(m.erase(k) == (ref.erase(k) == 1), "sequential erase"); break;
+      default: check(m.find(k) == (ref.contains(k) ? std::optional<u64>(ref[k]) : std::nullopt), "sequential find");
+    }
+    check(m.size() == ref.size(), "sequential size");
+    if (i % 5'000 == 0) {
+      const u64 lo = rng() % 2'000, hi = lo + rng() % 500;
+      std::vector<std::pair<u64, u64>> got, want(ref.lower_bound(lo), ref.lower_bound(hi));
+      m.for_each_in_range(lo, hi, [&](u64 key, u64 v) { got.emplace_back(key, v); });
+      check(got == want, "sequential range");
+    }
+  }
+  m.clear();
+  check(m.empty() && !m.contains(ref.empty() ? 0 : ref.begin()->first), "clear");
+}
+
+// Writers each own the keys congruent to their index; readers check that the
+// keys no writer touches (multiples of 7 placed up front) are always found,
+// and that a range walk sees every one of them, in order.
+void concurrent(unsigned writers, unsigned readers, u64 ops) {
+  constexpr u64 kRange = 20'000;
+  cmap m;
+  for (u64 k = 0; k < kRange; k += 7) m.insert_or_assign(k, k);
+  std::vector<std::map<u64, u64>> refs(writers);
+  std::atomic<bool> stop{false};
+  {
+    std::vector<std::jthread> pool;
+    for (unsigned r = 0; r < readers; ++r)
+      pool.emplace_back([&, r] {
+        std::mt19937_64 rng(100 + r);
+        while (!stop.load(std::memory_order_relaxed)) {
+          const u64 k = rng() % kRange / 7 * 7;
+          check(m.find(k) == k, "stable key missing");
+          if (rng() % 64 == 0) {
+            u64 prev = 0, seen = 0;
+            bool ordered = true;
+            m.for_each_in_range(0, kRange, [&](u64 key, u64) {
+              ordered &= seen == 0 || key > prev;
+              prev = key;
+              seen += key % 7 == 0;
+            });
+            check(ordered && seen == (kRange + 6) / 7, "range walk");
+          }
+        }
+      });
+    {
+      std::vector<std::jthread> writing;
+      for (unsigned w = 0; w < writers; ++w)
+        writing.emplace_back([&, w] {
+          std::mt19937_64 rng(w + 1);
+          auto& ref = refs[w];
+          for (u64 i = 0; i < ops; ++i) {
+            const u64 k = rng() % kRange;
+            if (k % 7 == 0 || k % writers != w) continue;
+            if (rng() % 2) check(m.insert_or_assign(k, i) == ref.insert_or_assign(k, i).second, "concurrent insert");
+            else check(m.erase(k) == (ref.erase(k) == 1), "concurrent erase");
+          }
+        });
+    }
+    stop = true;
+  }
+
+  std::map<u64, u64> want;
+  for (u64 k = 0; k < kRange; k += 7) want.emplace(k, k);
+  for (auto& ref : refs) want.insert(ref.begin(), ref.end());
+  std::vector<std::pair<u64, u64>> got;
+  m.for_each_in_range(0, kRange, [&](u64 k, u64 v) { got.emplace_back(k, v); });
+  check(std::ranges::equal(got, want, [](auto& a, auto& b) { return a.first == b.first && a.second == b.second; }),
+        "final contents");
+  check(m.size() == want.size(), "final size");
+}
+
+int main() {
+  for (u64 seed = 1; seed <= 3; ++seed) sequential(100'000, seed);
+  concurrent(4, 2, 200'000);
+  concurrent(8, 4, 100'000);
+
+  if (failures) {
+    std::cerr << failures << " check(s) failed\n";
+    return 1;
+  }
+  std::cout << "concurrent_avl: all checks passed\n";
+  return 0;
+}
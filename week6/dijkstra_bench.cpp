@@ -0,0 +1,97 @@
+#include <bits/stdc++.h>
+#include "heap.cpp"
+
+using u64 = unsigned long long;
+
+struct Graph {
+  std::vector<std::uint32_t> offset, to;
+  std::vector<u64> w;
+};
+
+// Random directed graph in CSR form: n vertices, n * degree edges.
+Graph random_graph(std::uint32_t n, std::uint32_t degree, std::uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  Graph g;
+  g.offset.resize(n + 1);
+  g.to.resize(std::size_t(n) * degree);
+  g.w.resize(g.to.size());
+  for (std::uint32_t u = 0; u <= n; ++u) g.offset[u] = u * degree;
+  for (std::size_t e = 0; e < g.to.size(); ++e) {
+    g.to[e] = static_cast<std::uint32_t>(rng() % n);
+    g.w[e] = 1 + rng() % 1'000'000;
+  }
+  return g;
+}
+
+using Item = std::pair<u64, std::uint32_t>;
+constexpr u64 kInf = std::numeric_limits<u64>::max();
+
+// Classic lazy deletion: every relaxation pushes, stale pops are skipped.
+std::vector<u64> dijkstra_lazy(const Graph& g, std::uint32_t src, std::size_t& peak) {
+  std::vector<u64> dist(g.offset.size() - 1, kInf);
+  Heap<Item, std::greater<>> pq;
+  dist[src] = 0;
+  pq.push({0, src});
+  peak = 1;
+  while (!pq.empty()) {
+    auto [d, u] = pq.pop();
+    if (d != dist[u]) continue;
+    for (auto e = g.offset[u]; e < g.offset[u + 1]; ++e) {
+      const u64 nd = d + g.w[e];
+      if (nd < dist[g.to[e]]) { dist[g.to[e]] = nd; pq.push({nd, g.to[e]}); }
+    }
+    peak = std::max(peak, pq.size());
+  }
+  return dist;
+}
+
+// At most one entry per vertex; relaxations decrease its key in place.
+std::vector<u64> dijkstra_decrease_key(const Graph& g, std::uint32_t src, std::size_t& peak) {
+  const std::size_t n = g.offset.size() - 1;
+  std::vector<u64> dist(n, kInf);
+  std::vector<IndexedHeap<Item, std::greater<>>::handle> where(n, IndexedHeap<Item, std::greater<>>::npos);
+  IndexedHeap<Item, std::greater<>> pq;
+  pq.reserve(n);
+  dist[src] = 0;
+  where[src] = pq.push({0, src});
+  peak = 1;
+  while (!pq.empty()) {
+    auto [d, u] = pq.pop();
+    for (auto e = g.offset[u]; e < g.offset[u + 1]; ++e) {
+      const auto v = g.to[e];
+      const u64 nd = d + g.w[e];
+      if (nd >= dist[v]) continue;
+      dist[v] = nd;
+      // A vertex is relaxed only before it is popped, so its handle is live.
+      if (where[v] == pq.npos) where[v] = pq.push({nd, v});
+      else pq.update(where[v], {nd, v});
+    }
+    peak = std::max(peak, pq.size());
+  }
+  return dist;
+}
+
+int main(int argc, char** argv) {
+  std::ios::sync_with_stdio(false);
+  std::cin.tie(nullptr);
+  std::cout.tie(nullptr);
+
+  const std::uint32_t n = argc > 1 ? std::stoul(argv[1]) : 1'000'000;
+  const std::uint32_t degree = argc > 2 ? std::stoul(argv[2]) : 8;
+  const auto g = random_graph(n, degree, 7);
+  std::cout << "n = " << n << ", m = " << g.to.size() << '\n';
+
+  std::vector<u64> ref;
+  auto run = [&](std::string_view name, auto&& algo) {
+    std::size_t peak = 0;
+    const auto t0 = std::chrono::steady_clock::now();
+    auto dist = algo(g, 0, peak);
+    const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    if (ref.empty()) ref = dist;
+    std::cout << std::left << std::setw(14) << name << std::right << std::fixed << std::setprecision(3)
+              << s << " s, peak heap " << peak << (dist == ref ? "" : "  MISMATCH") << '\n';
+  };
+  run("lazy", dijkstra_lazy);
+  run("decrease-key", dijkstra_decrease_key);
+  return 0;
+}
@@ -1,43 +1,150 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <iterator>
+#include <span>
 #include <vector>
 #include <concepts>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <new>
 #include <initializer_list>
 #include <stdexcept>
 #include <utility>
 #include <optional>
 #include <ranges>
+#include "../common/stats.h"
 
-template<class T, class Compare = std::less<>>
-requires std::strict_weak_order<Compare, T, T>
+// Shifts the start of the buffer so that element 1 (the first child of the
+// root) begins a cache line; with Arity * sizeof(T) dividing the line size
+// every sibling group of a d-ary heap then sits in a single line.
+template<class T, std::size_t Align = 64>
+struct HeapAllocator {
+  using value_type = T;
+  static constexpr std::size_t offset = (Align - sizeof(T) % Align) % Align;
+
+  HeapAllocator() = default;
+  template<class U> HeapAllocator(const HeapAllocator<U, Align>&) noexcept {}
+  template<class U> struct rebind { using other = HeapAllocator<U, Align>; };
+
+  T* allocate(std::size_t n) {
+    auto* p = static_cast<std::byte*>(::operator new(n * sizeof(T) + offset, std::align_val_t{Align}));
+    return reinterpret_cast<T*>(p + offset);
+  }
+  void deallocate(T* p, std::size_t) noexcept {
+    ::operator delete(reinterpret_cast<std::byte*>(p) - offset, std::align_val_t{Align});
+  }
+  template<class U> bool operator==(const HeapAllocator<U, Align>&) const noexcept { return true; }
+};
+
+template<class T, class Compare = std::less<>, std::size_t Arity = 4>
+requires std::strict_weak_order<Compare, T, T> && (Arity >= 2)
 class Heap {
-  std::vector<T> data;
+  std::vector<T, HeapAllocator<T>> data;
   Compare comp;
+  [[no_unique_address]] stats_counter counters;
 
-  static constexpr std::size_t parent_index(std::size_t i) noexcept { return (i - 1) >> 1; }
-  static constexpr std::size_t left_child(std::size_t i)   noexcept { return (i << 1) + 1; }
-  static constexpr std::size_t right_child(std::size_t i)  noexcept { return (i << 1) + 2; }
+  static constexpr std::size_t parent_index(std::size_t i) noexcept { return (i - 1) / Arity; }
+  static constexpr std::size_t first_child(std::size_t i)  noexcept { return i * Arity + 1; }
 
-  void sift_up(std::size_t i) {
-    while (i && comp(data[parent_index(i)], data[i])) {
-      std::swap(data[parent_index(i)], data[i]);
+  bool before(const T& a, const T& b) const {
+    counters.compare();
+    return comp(a, b);
+  }
+
+  std::size_t best_child(std::size_t first, std::size_t n) const {
+    const std::size_t last = std::min(first + Arity, n);
+    std::size_t best = first;
+    for (std::size_t c = first + 1; c < last; ++c)
+      best = before(data[best], data[c]) ? c : best;
+    return best;
+  }
+
+  // Hole-based sifts: the moving element is held aside and each level costs
+  // one move instead of a swap.
+  std::size_t sift_up(std::size_t i) {
+    if (!i || !before(data[parent_index(i)], data[i])) return i;
+    T x = std::move(data[i]);
+    std::uint64_t steps = 0;
+    do {
+      data[i] = std::move(data[parent_index(i)]);
       i = parent_index(i);
-    }
+      counters.sift();
+      ++steps;
+    } while (i && before(data[parent_index(i)], x));
+    data[i] = std::move(x);
+    counters.depth(steps);
+    return i;
   }
 
   void sift_down(std::size_t i) {
-    for (;;) {
-      std::size_t l = left_child(i), r = right_child(i), bestIdx = i;
-      if (l < data.size() && comp(data[bestIdx], data[l])) bestIdx = l;
-      if (r < data.size() && comp(data[bestIdx], data[r])) bestIdx = r;
-      if (bestIdx == i) break;
-      std::swap(data[i], data[bestIdx]);
-      i = bestIdx;
+    const std::size_t n = data.size();
+    T x = std::move(data[i]);
+    std::uint64_t steps = 0;
+    for (std::size_t c; (c = first_child(i)) < n; ) {
+      const std::size_t best = best_child(c, n);
+      if (!before(x, data[best])) break;
+      data[i] = std::move(data[best]);
+      i = best;
+      counters.sift();
+      ++steps;
     }
+    data[i] = std::move(x);
+    counters.depth(steps);
+  }
+
+  // Floyd's pop: walk the hole from the root down to a leaf along the best
+  // children without comparing against the displaced last element, then let
+  // that element climb back up, which is usually only a step or two.
+  void pop_root() {
+    T x = std::move(data.back());
+    data.pop_back();
+    const std::size_t n = data.size();
+    if (!n) return;
+    std::size_t i = 0;
+    std::uint64_t steps = 0;
+    for (std::size_t c; (c = first_child(i)) < n; ) {
+      const std::size_t best = best_child(c, n);
+      data[i] = std::move(data[best]);
+      i = best;
+      counters.sift();
+      ++steps;
+    }
+    counters.depth(steps);
+    while (i && before(data[parent_index(i)], x)) {
+      data[i] = std::move(data[parent_index(i)]);
+      i = parent_index(i);
+      counters.sift();
+    }
+    data[i] = std::move(x);
   }
   
+  void note_growth() const noexcept {
+    if (data.size() == data.capacity()) counters.allocate();
+  }
+
   void heapify() {
-    if (data.empty()) return;
-    for (std::size_t i = data.size() / 2; i-- > 0; ) sift_down(i);
+    if (data.size() < 2) return;
+    for (std::size_t i = parent_index(data.size() - 1) + 1; i-- > 0; ) sift_down(i);
+  }
+
+  // Restores the heap after data[old..) was appended. A few elements are
+  // sifted up one by one; larger batches re-heapify only their ancestors,
+  // which form one contiguous index range per level.
+  void restore_appended(std::size_t old) {
+    const std::size_t n = data.size(), k = n - old;
+    if (!k) return;
+    if (k * std::bit_width(n) < n) {
+      for (std::size_t i = old; i < n; ++i) sift_up(i);
+      return;
+    }
+    for (std::size_t lo = old, hi = n - 1; hi > 0; ) {
+      lo = lo ? parent_index(lo) : 0;
+      hi = parent_index(hi);
+      for (std::size_t i = hi + 1; i-- > lo; ) sift_down(i);
+    }
   }
 
 public:
@@ -45,10 +152,11 @@ public:
   using size_type = std::size_t;
   using reference = T&;
   using const_reference = const T&;
+  static constexpr std::size_t arity = Arity;
 
   Heap() = default;
   explicit Heap(Compare c) : comp(std::move(c)) {}
-  Heap(std::initializer_list<T> init, Compare c = {}) : data(init), comp(std::move(c)) { heapify(); }
+  Heap(std::initializer_list<T> init, Compare c = {}) : data(init.begin(), init.end()), comp(std::move(c)) { heapify(); }
 
   template<std::ranges::input_range R>
   requires std::convertible_to<std::ranges::range_value_t<R>, T>
@@ -61,32 +169,205 @@ public:
   [[nodiscard]] bool empty() const noexcept { return data.empty(); }
   [[nodiscard]] size_type size() const noexcept { return data.size(); }
 
+  // Comparisons, sift steps (levels an element moved), buffer growths and
+  // the longest single sift; all zero unless built with DSA_STATS.
+  [[nodiscard]] container_stats stats() const noexcept { return counters.get(); }
+  void reset_stats() noexcept { counters.reset(); }
+
   [[nodiscard]] const_reference top() const {
     if (data.empty()) throw std::out_of_range("Heap::top on empty heap");
     return data.front();
   }
 
   void push(const T& x) {
+    note_growth();
     data.push_back(x);
     sift_up(data.size() - 1);
   }
   void push(T&& x) {
+    note_growth();
     data.push_back(std::move(x));
     sift_up(data.size() - 1);
   }
   template<class... Args>
   reference emplace(Args&&... args) {
+    note_growth();
     data.emplace_back(std::forward<Args>(args)...);
-    sift_up(data.size() - 1);
-    return data.back();
+    return data[sift_up(data.size() - 1)];
   }
 
   [[nodiscard]] T pop() {
     if (data.empty()) throw std::out_of_range("Heap::pop on empty heap");
-    std::swap(data.front(), data.back());
-    T ret = std::move(data.back());
+    T ret = std::move(data.front());
+    pop_root();
+    return ret;
+  }
+
+  [[nodiscard]] std::optional<T> tryPop() {
+    if (data.empty()) return std::nullopt;
+    return pop();
+  }
+
+  template<std::ranges::input_range R>
+  requires std::convertible_to<std::ranges::range_value_t<R>, T>
+  void push_range(R&& r) {
+    const size_type old = data.size();
+    if constexpr (std::ranges::sized_range<R>) data.reserve(old + std::ranges::size(r));
+    for (auto&& x : r) data.emplace_back(std::forward<decltype(x)>(x));
+    restore_appended(old);
+  }
+
+  // Moves the top min(out.size(), size()) elements into out, best first, and
+  // returns how many were written. Large requests select and sort the prefix
+  // in one pass instead of paying a full pop per element.
+  size_type pop_n(std::span<T> out) {
+    const size_type k = std::min(out.size(), data.size());
+    if (!k) return 0;
+    if (k * 4 < data.size()) {
+      for (size_type i = 0; i < k; ++i) {
+        out[i] = std::move(data.front());
+        pop_root();
+      }
+      return k;
+    }
+    auto better = [this](const T& a, const T& b) { return before(b, a); };
+    std::nth_element(data.begin(), data.begin() + (k - 1), data.end(), better);
+    std::sort(data.begin(), data.begin() + k, better);
+    std::move(data.begin(), data.begin() + k, out.begin());
+    data.erase(data.begin(), data.begin() + k);
+    heapify();
+    return k;
+  }
+
+  // Absorbs other, appending the smaller heap to the larger one.
+  void merge(Heap&& other) {
+    if (this == &other) return;
+    if (other.data.size() > data.size()) data.swap(other.data);
+    const size_type old = data.size();
+    data.insert(data.end(), std::make_move_iterator(other.data.begin()), std::make_move_iterator(other.data.end()));
+    other.data.clear();
+    restore_appended(old);
+  }
+};
+
+// Addressable variant: push hands out a stable handle, and a handle -> slot
+// map lets update/erase find the element in O(1) before an O(log n) sift.
+// Handles of popped or erased elements are recycled by later pushes.
+template<class T, class Compare = std::less<>, std::size_t Arity = 4>
+requires std::strict_weak_order<Compare, T, T> && (Arity >= 2)
+class IndexedHeap {
+public:
+  using handle = std::size_t;
+  static constexpr handle npos = static_cast<handle>(-1);
+
+private:
+  struct Entry {
+    T key;
+    handle id;
+  };
+
+  std::vector<Entry, HeapAllocator<Entry>> data;
+  std::vector<std::size_t> pos;   // handle -> slot in data, npos when free
+  std::vector<handle> free_ids;
+  Compare comp;
+
+  static constexpr std::size_t parent_index(std::size_t i) noexcept { return (i - 1) / Arity; }
+  static constexpr std::size_t first_child(std::size_t i)  noexcept { return i * Arity + 1; }
+
+  void place(std::size_t i, Entry&& e) {
+    pos[e.id] = i;
+    data[i] = std::move(e);
+  }
+
+  void sift_up(std::size_t i) {
+    if (!i || !comp(data[parent_index(i)].key, data[i].key)) return;
+    Entry x = std::move(data[i]);
+    do {
+      place(i, std::move(data[parent_index(i)]));
+      i = parent_index(i);
+    } while (i && comp(data[parent_index(i)].key, x.key));
+    place(i, std::move(x));
+  }
+
+  void sift_down(std::size_t i) {
+    const std::size_t n = data.size();
+    Entry x = std::move(data[i]);
+    for (std::size_t c; (c = first_child(i)) < n; ) {
+      const std::size_t last = std::min(c + Arity, n);
+      std::size_t best = c;
+      for (std::size_t k = c + 1; k < last; ++k) best = comp(data[best].key, data[k].key) ? k : best;
+      if (!comp(x.key, data[best].key)) break;
+      place(i, std::move(data[best]));
+      i = best;
+    }
+    place(i, std::move(x));
+  }
+
+  std::size_t slot(handle h) const {
+    if (h >= pos.size() || pos[h] == npos) throw std::out_of_range("IndexedHeap: stale handle");
+    return pos[h];
+  }
+
+  // Moves the last entry into slot i and restores order around it.
+  void remove_at(std::size_t i) {
+    pos[data[i].id] = npos;
+    free_ids.push_back(data[i].id);
+    Entry last = std::move(data.back());
     data.pop_back();
-    if (!data.empty()) sift_down(0);
+    if (i == data.size()) return;
+    place(i, std::move(last));
+    if (i && comp(data[parent_index(i)].key, data[i].key)) sift_up(i);
+    else sift_down(i);
+  }
+
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using const_reference = const T&;
+
+  IndexedHeap() = default;
+  explicit IndexedHeap(Compare c) : comp(std::move(c)) {}
+
+  [[nodiscard]] bool empty() const noexcept { return data.empty(); }
+  [[nodiscard]] size_type size() const noexcept { return data.size(); }
+  void reserve(size_type n) { data.reserve(n); pos.reserve(n); }
+
+  [[nodiscard]] bool contains(handle h) const noexcept { return h < pos.size() && pos[h] != npos; }
+  [[nodiscard]] const_reference operator[](handle h) const { return data[slot(h)].key; }
+
+  [[nodiscard]] const_reference top() const {
+    if (data.empty()) throw std::out_of_range("IndexedHeap::top on empty heap");
+    return data.front().key;
+  }
+  [[nodiscard]] handle top_handle() const {
+    if (data.empty()) throw std::out_of_range("IndexedHeap::top_handle on empty heap");
+    return data.front().id;
+  }
+
+  handle push(T x) {
+    handle h;
+    if (free_ids.empty()) { h = pos.size(); pos.push_back(data.size()); }
+    else { h = free_ids.back(); free_ids.pop_back(); pos[h] = data.size(); }
+    data.push_back({std::move(x), h});
+    sift_up(data.size() - 1);
+    return h;
+  }
+
+  // Replaces the key of h; works for both increase and decrease.
+  void update(handle h, T x) {
+    const std::size_t i = slot(h);
+    const bool up = comp(data[i].key, x);
+    data[i].key = std::move(x);
+    if (up) sift_up(i);
+    else sift_down(i);
+  }
+
+  void erase(handle h) { remove_at(slot(h)); }
+
+  [[nodiscard]] T pop() {
+    if (data.empty()) throw std::out_of_range("IndexedHeap::pop on empty heap");
+    T ret = std::move(data.front().key);
+    remove_at(0);
     return ret;
   }
 
@@ -95,3 +376,95 @@ public:
     return pop();
   }
 };
+
+// Monotone min-queue for unsigned keys (Ahuja et al. radix heap): every
+// pushed key must be >= the last popped one. A key lives in the bucket
+// indexed by the highest bit in which it differs from that last key, so a
+// key moves to strictly lower buckets each time it is redistributed and
+// push/pop are O(1) amortized (O(digits) per key over its lifetime).
+template<std::unsigned_integral T>
+class RadixHeap {
+  static constexpr int kBuckets = std::numeric_limits<T>::digits + 1;
+
+  std::array<std::vector<T>, kBuckets> buckets;
+  T last = 0;  // last popped key; every bucket is relative to it
+  std::size_t count = 0;
+  // Smallest key outside bucket 0, cached by top(). top() finds it without
+  // redistributing: moving last on a peek would raise the floor that push()
+  // checks against above the last key actually popped.
+  mutable std::optional<T> peeked;
+
+  static int bucket_of(T x, T base) noexcept { return std::bit_width(static_cast<T>(x ^ base)); }
+
+  int first_nonempty() const noexcept {
+    int i = 1;
+    while (buckets[i].empty()) ++i;
+    return i;
+  }
+
+  void refill() {
+    if (!buckets[0].empty()) return;
+    auto& b = buckets[first_nonempty()];
+    last = peeked ? *peeked : *std::min_element(b.begin(), b.end());
+    peeked.reset();
+    for (T x : b) buckets[bucket_of(x, last)].push_back(x);
+    b.clear();
+  }
+
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using const_reference = const T&;
+
+  RadixHeap() = default;
+
+  [[nodiscard]] bool empty() const noexcept { return count == 0; }
+  [[nodiscard]] size_type size() const noexcept { return count; }
+
+  [[nodiscard]] const_reference top() const {
+    if (!count) throw std::out_of_range("RadixHeap::top on empty heap");
+    if (!buckets[0].empty()) return buckets[0].back();
+    if (!peeked) {
+      const auto& b = buckets[first_nonempty()];
+      peeked = *std::min_element(b.begin(), b.end());
+    }
+    return *peeked;
+  }
+
+  void push(T x) {
+    if (x < last) throw std::invalid_argument("RadixHeap::push key below the last popped key");
+    const int i = bucket_of(x, last);
+    buckets[i].push_back(x);
+    if (i && peeked && x < *peeked) peeked = x;
+    ++count;
+  }
+
+  [[nodiscard]] T pop() {
+    if (!count) throw std::out_of_range("RadixHeap::pop on empty heap");
+    refill();
+    const T ret = buckets[0].back();
+    buckets[0].pop_back();
+    --count;
+    return ret;
+  }
+
+  [[nodiscard]] std::optional<T> tryPop() {
+    if (!count) return std::nullopt;
+    return pop();
+  }
+};
+
+template<class Compare, class T>
+concept MinOrder = std::same_as<Compare, std::greater<>> || std::same_as<Compare, std::greater<T>>;
+
+// Picks RadixHeap when the caller declares monotone use of an unsigned
+// min-queue, and the general Heap otherwise.
+template<class T, class Compare, bool Monotone>
+struct SelectPriorityQueue { using type = Heap<T, Compare>; };
+
+template<std::unsigned_integral T, class Compare>
+requires MinOrder<Compare, T>
+struct SelectPriorityQueue<T, Compare, true> { using type = RadixHeap<T>; };
+
+template<class T, class Compare = std::less<>, bool Monotone = false>
+using PriorityQueue = typename SelectPriorityQueue<T, Compare, Monotone>::type;
@@ -0,0 +1,141 @@
+#include <bits/stdc++.h>
+#include "heap.cpp"
+
+using u64 = unsigned long long;
+
+// The binary heap as it stood before Heap became d-ary: a swap at every
+// level on the way up and down, pop swapping the last element to the root.
+// Kept here as the baseline the d-ary layouts are measured against.
+template <class T>
+class SwapHeap {
+  std::vector<T> data;
+
+public:
+  [[nodiscard]] bool empty() const noexcept { return data.empty(); }
+
+  void push(const T& x) {
+    data.push_back(x);
+    for (std::size_t i = data.size() - 1; i && data[(i - 1) >> 1] < data[i]; i = (i - 1) >> 1)
+      std::swap(data[(i - 1) >> 1], data[i]);
+  }
+
+  T pop() {
+    std::swap(data.front(), data.back());
+    T ret = std::move(data.back());
+    data.pop_back();
+    for (std::size_t i = 0;;) {
+      std::size_t l = (i << 1) + 1, r = l + 1, best = i;
+      if (l < data.size() && data[best] < data[l]) best = l;
+      if (r < data.size() && data[best] < data[r]) best = r;
+      if (best == i) break;
+      std::swap(data[i], data[best]);
+      i = best;
+    }
+    return ret;
+  }
+};
+
+// Fills a heap with n random keys, then drains it; reports both phases.
+template <class H>
+void run(std::string_view name, const std::vector<u64>& keys) {
+  using clock = std::chrono::steady_clock;
+  H h;
+  const auto t0 = clock::now();
+  for (u64 k : keys) h.push(k);
+  const auto t1 = clock::now();
+  u64 check = 0, prev = ~0ULL;
+  bool ok = true;
+  while (!h.empty()) {
+    u64 x;
+    if constexpr (requires { h.top(); h.pop(); typename H::container_type; }) { x = h.top(); h.pop(); }
+    else x = h.pop();
+    ok &= x <= prev;
+    prev = x;
+    check += x;
+  }
+  const auto t2 = clock::now();
+
+  const double n = static_cast<double>(keys.size());
+  const double push_s = std::chrono::duration<double>(t1 - t0).count();
+  const double pop_s = std::chrono::duration<double>(t2 - t1).count();
+  std::cout << std::left << std::setw(22) << name << std::right << std::fixed << std::setprecision(1)
+            << " push " << std::setw(8) << n / push_s / 1e6 << " Mops/s"
+            << "  pop " << std::setw(8) << n / pop_s / 1e6 << " Mops/s"
+            << (ok ? "" : "  ORDER VIOLATION") << "  (" << (check & 0xff) << ")\n";
+}
+
+// Bulk paths against the one-at-a-time loops they replace: half of the keys
+// are loaded first, the other half is appended, then a quarter is drained.
+void run_batch(const std::vector<u64>& keys) {
+  using clock = std::chrono::steady_clock;
+  auto secs = [](auto a, auto b) { return std::chrono::duration<double>(b - a).count(); };
+  const std::size_t half = keys.size() / 2, quarter = keys.size() / 4;
+  const std::span<const u64> first(keys.data(), half), second(keys.data() + half, keys.size() - half);
+  std::vector<u64> out(quarter);
+
+  Heap<u64> a(first), b(first);
+  auto t0 = clock::now();
+  for (u64 k : second) a.push(k);
+  auto t1 = clock::now();
+  b.push_range(second);
+  auto t2 = clock::now();
+  for (auto& x : out) x = a.pop();
+  auto t3 = clock::now();
+  b.pop_n(out);
+  auto t4 = clock::now();
+
+  Heap<u64> c(first), d(second);
+  auto t5 = clock::now();
+  c.merge(std::move(d));
+  auto t6 = clock::now();
+
+  std::cout << std::fixed << std::setprecision(1)
+            << "append " << second.size() << ": push loop " << secs(t0, t1) * 1e3 << " ms, push_range " << secs(t1, t2) * 1e3 << " ms\n"
+            << "drain  " << quarter << ": pop loop " << secs(t2, t3) * 1e3 << " ms, pop_n " << secs(t3, t4) * 1e3 << " ms\n"
+            << "merge  " << half << " + " << second.size() << ": " << secs(t5, t6) * 1e3 << " ms\n";
+}
+
+// Event-scheduler hold model: pop the earliest timestamp, schedule a new
+// event a random delay later. Keys only grow, which RadixHeap relies on.
+template <class Q>
+void run_monotone(std::string_view name, std::size_t n) {
+  std::mt19937_64 rng(n);
+  Q q;
+  for (std::size_t i = 0; i < n; ++i) q.push(rng() % 1'000'000);
+  u64 check = 0;
+  const auto t0 = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < 4 * n; ++i) {
+    const u64 now = q.pop();
+    check += now;
+    q.push(now + 1 + rng() % 1'000'000);
+  }
+  const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  std::cout << std::left << std::setw(22) << name << std::right << std::fixed << std::setprecision(1)
+            << " hold " << std::setw(8) << 4 * n / s / 1e6 << " Mops/s  (" << (check & 0xff) << ")\n";
+}
+
+int main(int argc, char** argv) {
+  std::ios::sync_with_stdio(false);
+  std::cin.tie(nullptr);
+  std::cout.tie(nullptr);
+
+  std::vector<std::size_t> sizes;
+  for (int i = 1; i < argc; ++i) sizes.push_back(std::stoull(argv[i]));
+  if (sizes.empty()) sizes = {1'000'000, 10'000'000};
+
+  for (auto n : sizes) {
+    std::mt19937_64 rng(n);
+    std::vector<u64> keys(n);
+    for (auto& k : keys) k = rng();
+    std::cout << "n = " << n << '\n';
+    run<std::priority_queue<u64>>("std::priority_queue", keys);
+    run<SwapHeap<u64>>("binary (before d-ary)", keys);
+    run<Heap<u64, std::less<>, 2>>("Heap<2>", keys);
+    run<Heap<u64, std::less<>, 4>>("Heap<4>", keys);
+    run<Heap<u64, std::less<>, 8>>("Heap<8>", keys);
+    run_batch(keys);
+    run_monotone<PriorityQueue<u64, std::greater<>>>("Heap (min)", n);
+    run_monotone<PriorityQueue<u64, std::greater<>, true>>("RadixHeap", n);
+  }
+  return 0;
+}
@@ -0,0 +1,103 @@
+#include <bits/stdc++.h>
+#include "heap.cpp"
+
+using u64 = unsigned long long;
+
+int failures = 0;
+
+void check(bool ok, std::string_view what, u64 step) {
+  if (ok) return;
+  std::cerr << "FAIL: " << what << " at step " << step << '\n';
+  ++failures;
+}
+
+// A peek between a pop and a push must not raise the floor push() checks:
+// after popping 5, top() sees 10, and 7 is still a legal key.
+void radix_peek_then_push() {
+  const std::string_view what = "RadixHeap push/pop/top/push";
+  RadixHeap<u64> h;
+  h.push(5);
+  h.push(10);
+  check(h.pop() == 5, what, 0);
+  check(h.top() == 10, what, 1);
+  try {
+    h.push(7);
+  } catch (const std::invalid_argument&) {
+    check(false, what, 2);
+    return;
+  }
+  check(h.top() == 7, what, 3);
+  check(h.pop() == 7, what, 4);
+  check(h.pop() == 10, what, 5);
+  check(h.empty(), what, 6);
+
+  bool threw = false;
+  h.push(12);
+  (void)h.pop();
+  try {
+    h.push(11);
+  } catch (const std::invalid_argument&) {
+    threw = true;
+  }
+  check(threw, "RadixHeap push below the last popped key", 7);
+}
+
+// Random monotone use with peeks in between, against std::multiset.
+void radix_random(u64 steps, u64 seed) {
+  const std::string what = "RadixHeap random seed " + std::to_string(seed);
+  std::mt19937_64 rng(seed);
+  RadixHeap<u64> h;
+  std::multiset<u64> m;
+  u64 floor = 0;
+  for (u64 i = 0; i < steps; ++i) {
+    const unsigned p = rng() % 8;
+    if (p < 4 || m.empty()) {
+      const u64 k = floor + rng() % (p == 0 ? 4 : 1'000);
+      h.push(k);
+      m.insert(k);
+    } else if (p < 6) {
+      check(h.top() == *m.begin(), what, i);
+    } else {
+      floor = h.pop();
+      check(floor == *m.begin(), what, i);
+      m.erase(m.begin());
+    }
+    check(h.size() == m.size(), what, i);
+  }
+}
+
+// Every arity drains in order, against std::priority_queue.
+template <std::size_t Arity>
+void heap_random(u64 n, u64 seed) {
+  const std::string what = "Heap<" + std::to_string(Arity) + "> random";
+  std::mt19937_64 rng(seed);
+  Heap<u64, std::less<>, Arity> h;
+  std::priority_queue<u64> q;
+  for (u64 i = 0; i < n; ++i) {
+    const u64 k = rng() % 1'000;
+    if (rng() % 3 == 0 && !q.empty()) {
+      check(h.pop() == q.top(), what, i);
+      q.pop();
+    } else {
+      h.push(k);
+      q.push(k);
+    }
+  }
+  for (u64 i = 0; !q.empty(); ++i, q.pop()) check(h.pop() == q.top(), what, n + i);
+  check(h.empty(), what, n);
+}
+
+int main() {
+  radix_peek_then_push();
+  for (u64 seed = 1; seed <= 4; ++seed) radix_random(200'000, seed);
+  heap_random<2>(100'000, 1);
+  heap_random<4>(100'000, 2);
+  heap_random<8>(100'000, 3);
+
+  if (failures) {
+    std::cerr << failures << " check(s) failed\n";
+    return 1;
+  }
+  std::cout << "heap: all checks passed\n";
+  return 0;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "heap.cpp"
+
+// Relaxed concurrent priority queue (MultiQueue): the elements are spread over
+// several independently locked Heaps. push goes to a random lane; pop locks
+// two random lanes and takes the better of their tops. More lanes mean less
+// contention but a larger rank error, which grows roughly linearly with the
+// lane count; a single lane degenerates to a strict mutex-protected Heap.
+template<class T, class Compare = std::less<>, std::size_t Arity = 4>
+requires std::strict_weak_order<Compare, T, T>
+class MultiQueue {
+  struct alignas(64) Lane {
+    std::mutex mu;
+    Heap<T, Compare, Arity> heap;
+    std::atomic<std::size_t> size{0};
+    explicit Lane(const Compare& c) : heap(c) {}
+  };
+
+  std::vector<std::unique_ptr<Lane>> lanes;
+  Compare comp;
+
+  // xorshift64*, one stream per thread.
+  static std::uint64_t next_random() noexcept {
+    thread_local std::uint64_t s = std::hash<std::thread::id>{}(std::this_thread::get_id()) | 1;
+    s ^= s >> 12; s ^= s << 25; s ^= s >> 27;
+    return s * 0x2545F4914F6CDD1DULL;
+  }
+  std::size_t random_lane() const noexcept { return next_random() % lanes.size(); }
+
+  std::optional<T> pop_scan() {
+    for (auto& l : lanes) {
+      if (!l->size.load(std::memory_order_relaxed)) continue;
+      std::lock_guard lk(l->mu);
+      if (l->heap.empty()) continue;
+      l->size.store(l->heap.size() - 1, std::memory_order_relaxed);
+      return l->heap.pop();
+    }
+    return std::nullopt;
+  }
+
+public:
+  using value_type = T;
+
+  // lanes_per_thread is the relaxation knob: lane count = threads * lanes_per_thread.
+  explicit MultiQueue(unsigned threads, unsigned lanes_per_thread = 2, Compare c = {}) : comp(std::move(c)) {
+    const std::size_t n = std::max<std::size_t>(1, std::size_t(threads) * lanes_per_thread);
+    lanes.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) lanes.push_back(std::make_unique<Lane>(comp));
+  }
+
+  [[nodiscard]] std::size_t lane_count() const noexcept { return lanes.size(); }
+
+  // Approximate while other threads are active.
+  [[nodiscard]] std::size_t size() const noexcept {
+    std::size_t n = 0;
+    for (auto& l : lanes) n += l->size.load(std::memory_order_relaxed);
+    return n;
+  }
+
+  void push(T x) {
+    for (int attempt = 0; ; ++attempt) {
+      Lane& l = *lanes[random_lane()];
+      std::unique_lock lk(l.mu, std::try_to_lock);
+      if (!lk && attempt < 8) continue;
+      if (!lk) lk.lock();
+      l.heap.push(std::move(x));
+      l.size.store(l.heap.size(), std::memory_order_relaxed);
+      return;
+    }
+  }
+
+  // Returns nullopt only after a full scan found every lane empty.
+  [[nodiscard]] std::optional<T> tryPop() {
+    if (lanes.size() == 1) return pop_scan();
+    for (int attempt = 0; attempt < 8; ++attempt) {
+      std::size_t i = random_lane(), j = random_lane();
+      if (i == j) j = (j + 1) % lanes.size();
+      if (i > j) std::swap(i, j);
+      Lane& a = *lanes[i];
+      Lane& b = *lanes[j];
+      std::unique_lock la(a.mu, std::try_to_lock);
+      if (!la) continue;
+      std::unique_lock lb(b.mu, std::try_to_lock);
+      Lane* best = a.heap.empty() ? nullptr : &a;
+      if (lb && !b.heap.empty() && (!best || comp(best->heap.top(), b.heap.top()))) best = &b;
+      if (!best) continue;
+      best->size.store(best->heap.size() - 1, std::memory_order_relaxed);
+      return best->heap.pop();
+    }
+    return pop_scan();
+  }
+};
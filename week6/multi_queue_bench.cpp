@@ -0,0 +1,92 @@
+#include <bits/stdc++.h>
+#include "multi_queue.cpp"
+
+using u64 = unsigned long long;
+
+// Baseline: what the workers do today, one Heap behind one mutex.
+struct LockedHeap {
+  std::mutex mu;
+  Heap<u64> heap;
+  explicit LockedHeap(unsigned) {}
+  void push(u64 x) { std::lock_guard lk(mu); heap.push(x); }
+  std::optional<u64> tryPop() { std::lock_guard lk(mu); return heap.tryPop(); }
+};
+
+template <class Q, class... Args>
+double throughput(unsigned threads, std::size_t prefill, std::size_t ops, Args... args) {
+  Q q(threads, args...);
+  std::mt19937_64 rng(1);
+  for (std::size_t i = 0; i < prefill; ++i) q.push(rng());
+  std::atomic<bool> go{false};
+  std::vector<std::jthread> pool;
+  for (unsigned t = 0; t < threads; ++t) pool.emplace_back([&, t] {
+    std::mt19937_64 r(t + 2);
+    while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+    for (std::size_t i = 0; i < ops / threads; ++i) {
+      if (i & 1) (void)q.tryPop();
+      else q.push(r());
+    }
+  });
+  const auto t0 = std::chrono::steady_clock::now();
+  go.store(true, std::memory_order_release);
+  pool.clear();
+  return ops / std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Rank error: threads drain a queue holding the keys 0..n-1 and stamp every pop
+// with a global ticket. Replaying the pops in ticket order, the rank of a key
+// is how many larger keys were still present; a strict queue always scores 0.
+template <class Q, class... Args>
+std::pair<double, u64> rank_error(unsigned threads, std::size_t n, Args... args) {
+  Q q(threads, args...);
+  std::vector<u64> keys(n);
+  std::iota(keys.begin(), keys.end(), 0);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937_64(3));
+  for (u64 k : keys) q.push(k);
+
+  std::vector<u64> order(n);
+  std::atomic<std::size_t> ticket{0};
+  {
+    std::vector<std::jthread> pool;
+    for (unsigned t = 0; t < threads; ++t) pool.emplace_back([&] {
+      while (auto x = q.tryPop()) order[ticket.fetch_add(1, std::memory_order_relaxed)] = *x;
+    });
+  }
+
+  std::vector<std::uint32_t> fen(n + 1, 0);  // Fenwick tree over present keys
+  auto add = [&](std::size_t i, int d) { for (++i; i <= n; i += i & -i) fen[i] += d; };
+  auto prefix = [&](std::size_t i) { u64 s = 0; for (; i; i -= i & -i) s += fen[i]; return s; };
+  for (std::size_t i = 0; i < n; ++i) add(i, 1);
+  u64 sum = 0, worst = 0;
+  for (std::size_t i = 0; i < ticket.load(); ++i) {
+    const u64 k = order[i];
+    const u64 rank = prefix(n) - prefix(k + 1);
+    sum += rank;
+    worst = std::max(worst, rank);
+    add(k, -1);
+  }
+  return {double(sum) / n, worst};
+}
+
+int main(int argc, char** argv) {
+  std::ios::sync_with_stdio(false);
+  std::cin.tie(nullptr);
+  std::cout.tie(nullptr);
+
+  const unsigned max_threads = argc > 1 ? std::stoul(argv[1]) : 64;
+  const unsigned c = argc > 2 ? std::stoul(argv[2]) : 2;
+  const std::size_t prefill = 1 << 20, ops = 1 << 22, quality_n = 1 << 20;
+
+  // Past this many threads the rows measure oversubscription, not scaling.
+  std::cout << "hardware threads: " << std::thread::hardware_concurrency() << '\n';
+  std::cout << "threads  locked Mops/s  multiqueue(c=" << c << ") Mops/s  mean rank  max rank\n";
+  for (unsigned t = 1; t <= max_threads; t *= 2) {
+    const double base = throughput<LockedHeap>(t, prefill, ops);
+    const double mq = throughput<MultiQueue<u64>>(t, prefill, ops, c);
+    const auto [mean, worst] = rank_error<MultiQueue<u64>>(t, quality_n, c);
+    std::cout << std::setw(7) << t << std::fixed << std::setprecision(2)
+              << std::setw(15) << base / 1e6 << std::setw(26) << mq / 1e6
+              << std::setw(11) << mean << std::setw(10) << worst << '\n';
+  }
+  return 0;
+}
@@ -0,0 +1,263 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <utility>
+#include <vector>
+#include "avl.cpp"
+
+// Persistent (path-copying) AVL map. Nodes are immutable and shared between
+// versions through refcounted pointers: an update copies only the O(log n)
+// nodes on its search path, and snapshot() is O(1). A snapshot is a frozen
+// version that any number of threads may read without locks while writers
+// keep publishing new roots with compare-and-swap.
+template <typename Key, typename T, KeyComparator<Key> Compare = std::less<Key>>
+class persistent_avl_tree {
+  private:
+    struct Node;
+    using link = std::shared_ptr<const Node>;
+    using value_type = std::pair<const Key, T>;
+
+    struct Node {
+      value_type kv;
+      link left;
+      link right;
+      int height;
+      std::size_t count;
+    };
+
+    std::atomic<link> root_{};
+    [[no_unique_address]] Compare comp_{};
+
+    static int height_of(const link& n) noexcept { return n ? n->height : 0; }
+    static std::size_t count_of(const link& n) noexcept { return n ? n->count : 0; }
+
+    static link make(const value_type& kv, link l, link r) {
+      const int h = 1 + std::max(height_of(l), height_of(r));
+      const std::size_t c = 1 + count_of(l) + count_of(r);
+      return std::make_shared<const Node>(Node{kv, std::move(l), std::move(r), h, c});
+    }
+
+    // New node over l and r, with at most one single or double rotation;
+    // the heights of l and r may differ by at most two.
+    static link balance(const value_type& kv, link l, link r) {
+      const int hl = height_of(l), hr = height_of(r);
+      if (hl > hr + 1) {
+        if (height_of(l->left) >= height_of(l->right)) return make(l->kv, l->left, make(kv, l->right, std::move(r)));
+        const link& lr = l->right;
+        return make(lr->kv, make(l->kv, l->left, lr->left), make(kv, lr->right, std::move(r)));
+      }
+      if (hr > hl + 1) {
+        if (height_of(r->right) >= height_of(r->left)) return make(r->kv, make(kv, std::move(l), r->left), r->right);
+        const link& rl = r->left;
+        return make(rl->kv, make(kv, std::move(l), rl->left), make(r->kv, rl->right, r->right));
+      }
+      return make(kv, std::move(l), std::move(r));
+    }
+
+    link insert(const link& n, const value_type& kv, bool& inserted) const {
+      if (!n) {
+        inserted = true;
+        return make(kv, nullptr, nullptr);
+      }
+      if (comp_(kv.first, n->kv.first)) return balance(n->kv, insert(n->left, kv, inserted), n->right);
+      if (comp_(n->kv.first, kv.first)) return balance(n->kv, n->left, insert(n->right, kv, inserted));
+      return make(kv, n->left, n->right);
+    }
+
+    // Unlinks the leftmost node of n into min.
+    static link erase_min(const link& n, link& min) {
+      if (!n->left) {
+        min = n;
+        return n->right;
+      }
+      return balance(n->kv, erase_min(n->left, min), n->right);
+    }
+
+    // Returns n itself when key is absent, so a miss allocates nothing.
+    link erase(const link& n, const Key& key) const {
+      if (!n) return n;
+      if (comp_(key, n->kv.first)) {
+        link l = erase(n->left, key);
+        return l == n->left ? n : balance(n->kv, std::move(l), n->right);
+      }
+      if (comp_(n->kv.first, key)) {
+        link r = erase(n->right, key);
+        return r == n->right ? n : balance(n->kv, n->left, std::move(r));
+      }
+      if (!n->left) return n->right;
+      if (!n->right) return n->left;
+      link min;
+      link r = erase_min(n->right, min);
+      return balance(min->kv, n->left, std::move(r));
+    }
+
+    // Applies step to the current root until the result is published
+    // without another writer having moved the root in between.
+    template <typename Step>
+    link update(Step step) {
+      link cur = root_.load();
+      for (;;) {
+        link next = step(cur);
+        if (next == cur || root_.compare_exchange_weak(cur, next)) return next;
+      }
+    }
+
+  public:
+    using key_type = Key;
+    using mapped_type = T;
+
+    // Read-only view of one version. Holding it keeps that version alive;
+    // copies are O(1) and reads need no synchronization.
+    class snapshot_type {
+        link root_;
+        [[no_unique_address]] Compare comp_;
+        friend class persistent_avl_tree;
+        snapshot_type(link root, const Compare& comp) : root_(std::move(root)), comp_(comp) {}
+
+        const Node* find_node(const Key& key) const noexcept {
+          const Node* n = root_.get();
+          while (n) {
+            if (comp_(key, n->kv.first)) n = n->left.get();
+            else if (comp_(n->kv.first, key)) n = n->right.get();
+            else return n;
+          }
+          return nullptr;
+        }
+
+      public:
+        // In-order iterator; the stack holds the current node and the
+        // ancestors still to be visited.
+        class const_iterator {
+            std::vector<const Node*> stack_;
+            friend class snapshot_type;
+
+            void push_left(const Node* n) {
+              for (; n; n = n->left.get()) stack_.push_back(n);
+            }
+
+          public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::pair<const Key, T>;
+            using difference_type = std::ptrdiff_t;
+            using reference = const value_type&;
+            using pointer = const value_type*;
+
+            const_iterator() = default;
+            reference operator*() const noexcept { return stack_.back()->kv; }
+            pointer operator->() const noexcept { return &stack_.back()->kv; }
+            const_iterator& operator++() {
+              const Node* n = stack_.back();
+              stack_.pop_back();
+              push_left(n->right.get());
+              return *this;
+            }
+            const_iterator operator++(int) { auto t = *this; ++*this; return t; }
+            friend bool operator==(const const_iterator& a, const const_iterator& b) noexcept {
+              if (a.stack_.empty() || b.stack_.empty()) return a.stack_.empty() == b.stack_.empty();
+              return a.stack_.back() == b.stack_.back();
+            }
+        };
+
+        [[nodiscard]] std::size_t size() const noexcept { return count_of(root_); }
+        [[nodiscard]] bool empty() const noexcept { return !root_; }
+
+        [[nodiscard]] const T* find(const Key& key) const noexcept { if (auto* n = find_node(key)) return &n->kv.second; return nullptr; }
+        [[nodiscard]] bool contains(const Key& key) const noexcept { return find_node(key) != nullptr; }
+
+        [[nodiscard]] const_iterator begin() const {
+          const_iterator it;
+          it.push_left(root_.get());
+          return it;
+        }
+        [[nodiscard]] const_iterator end() const noexcept { return {}; }
+
+        [[nodiscard]] const_iterator lower_bound(const Key& key) const {
+          const_iterator it;
+          for (const Node* n = root_.get(); n;) {
+            if (comp_(n->kv.first, key)) {
+              n = n->right.get();
+            } else {
+              it.stack_.push_back(n);
+              n = n->left.get();
+            }
+          }
+          return it;
+        }
+
+        // Entries with lo <= key < hi.
+        [[nodiscard]] std::ranges::subrange<const_iterator> range(const Key& lo, const Key& hi) const {
+          if (!comp_(lo, hi)) return {end(), end()};
+          return {lower_bound(lo), lower_bound(hi)};
+        }
+
+        template <typename F>
+        requires std::invocable<F&, const Key&, const T&>
+        void for_each_inorder(F f) const {
+          for (auto& [k, v] : *this) std::invoke(f, k, v);
+        }
+
+        [[nodiscard]] auto to_vector() const -> std::vector<std::pair<Key, T>> {
+          std::vector<std::pair<Key, T>> out;
+          out.reserve(size());
+          for (auto& kv : *this) out.push_back(kv);
+          return out;
+        }
+    };
+
+    persistent_avl_tree() = default;
+    explicit persistent_avl_tree(Compare comp) : comp_(std::move(comp)) {}
+
+    persistent_avl_tree(std::initializer_list<std::pair<Key, T>> init, Compare comp = {}) : comp_(std::move(comp)) {
+      for (auto&& p : init) insert_or_assign(p.first, p.second);
+    }
+
+    // Copies share every node with the source.
+    persistent_avl_tree(const persistent_avl_tree& o) : root_(o.root_.load()), comp_(o.comp_) {}
+    persistent_avl_tree& operator=(const persistent_avl_tree& o) {
+      if (this != &o) {
+        root_.store(o.root_.load());
+        comp_ = o.comp_;
+      }
+      return *this;
+    }
+
+    // O(1); safe to call while other threads update the tree.
+    [[nodiscard]] snapshot_type snapshot() const { return {root_.load(), comp_}; }
+
+    [[nodiscard]] std::size_t size() const noexcept { return count_of(root_.load()); }
+    [[nodiscard]] bool empty() const noexcept { return !root_.load(); }
+
+    // Lookups on the live tree return copies, since the node may be released
+    // by a concurrent update; use a snapshot to read in place.
+    [[nodiscard]] std::optional<T> find(const Key& key) const {
+      if (const T* v = snapshot().find(key)) return *v;
+      return std::nullopt;
+    }
+    [[nodiscard]] bool contains(const Key& key) const noexcept { return snapshot().contains(key); }
+
+    // Returns true when key was not present before.
+    bool insert_or_assign(const Key& key, T value) {
+      const value_type kv(key, std::move(value));
+      bool inserted = false;
+      update([&](const link& root) {
+        inserted = false;
+        return insert(root, kv, inserted);
+      });
+      return inserted;
+    }
+
+    bool erase(const Key& key) {
+      bool erased = false;
+      update([&](const link& root) {
+        link next = erase(root, key);
+        erased = next != root;
+        return next;
+      });
+      return erased;
+    }
+
+    // Existing snapshots keep their nodes alive.
+    void clear() noexcept { root_.store(nullptr); }
+};
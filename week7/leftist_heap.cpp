@@ -1,3 +1,4 @@
+#pragma once
 #include <memory>
 #include <utility>
 #include <stdexcept>
@@ -6,6 +7,113 @@
 #include <cstddef>
 #include <type_traits>
 #include <ranges>
+#include <vector>
+#include <algorithm>
+#include <new>
+#include "../common/stats.h"
+
+// Node storage for the heaps below. Freed nodes are chained into a free list
+// and reused. Blocks double from one node up to 4096, so a heap holding a
+// single element costs a single allocation; each block's first slot links
+// it to the next block. Merging heaps splices the donor's blocks and free
+// list into the receiver in O(1), since its nodes change owner.
+template <class N>
+class NodePool {
+  union Slot {
+    Slot* next;
+    alignas(N) unsigned char storage[sizeof(N)];
+  };
+
+  Slot* blocks_ = nullptr;
+  Slot* blocks_tail_ = nullptr;
+  Slot* free_ = nullptr;
+  Slot* free_tail_ = nullptr;
+  std::size_t capacity_ = 0;
+
+  void push_free(Slot* s) noexcept {
+    s->next = free_;
+    free_ = s;
+    if (!free_tail_) free_tail_ = s;
+  }
+
+  void release() noexcept {
+    while (blocks_) delete[] std::exchange(blocks_, blocks_->next);
+    blocks_tail_ = free_ = free_tail_ = nullptr;
+    capacity_ = 0;
+  }
+
+public:
+  NodePool() = default;
+  NodePool(const NodePool&) = delete;
+  NodePool& operator=(const NodePool&) = delete;
+  NodePool(NodePool&& o) noexcept { splice(o); }
+  NodePool& operator=(NodePool&& o) noexcept {
+    if (this != &o) {
+      release();
+      splice(o);
+    }
+    return *this;
+  }
+  // Live nodes must have been destroyed by the owner.
+  ~NodePool() { release(); }
+
+  // Returns raw storage for n adjacent nodes in a block of its own; slots
+  // that end up unused go back through deallocate.
+  N* allocate_run(std::size_t n) {
+    static_assert(sizeof(Slot) == sizeof(N), "nodes must tile a block");
+    Slot* b = new Slot[n + 1];
+    b->next = blocks_;
+    blocks_ = b;
+    if (!blocks_tail_) blocks_tail_ = b;
+    capacity_ += n;
+    return reinterpret_cast<N*>(b + 1);
+  }
+
+  // Adds a block of n nodes to the free list.
+  void grow(std::size_t n) {
+    N* run = allocate_run(n);
+    for (std::size_t i = n; i > 0; --i) deallocate(run + i - 1);
+  }
+
+  template <class... Args>
+  N* create(Args&&... args) {
+    if (!free_) grow(std::clamp<std::size_t>(capacity_, 1, 4096));
+    Slot* s = free_;
+    free_ = s->next;
+    if (!free_) free_tail_ = nullptr;
+    try {
+      return ::new (static_cast<void*>(s->storage)) N(std::forward<Args>(args)...);
+    } catch (...) {
+      push_free(s);
+      throw;
+    }
+  }
+
+  void destroy(N* n) noexcept {
+    n->~N();
+    deallocate(n);
+  }
+
+  // Returns the storage of a node that was never constructed or already
+  // destroyed.
+  void deallocate(N* n) noexcept { push_free(reinterpret_cast<Slot*>(n)); }
+
+  // Takes over every block of o; the caller becomes responsible for o's live
+  // nodes.
+  void splice(NodePool& o) noexcept {
+    if (this == &o || !o.blocks_) return;
+    o.blocks_tail_->next = blocks_;
+    blocks_ = std::exchange(o.blocks_, nullptr);
+    if (!blocks_tail_) blocks_tail_ = o.blocks_tail_;
+    if (o.free_) {
+      o.free_tail_->next = free_;
+      free_ = o.free_;
+      if (!free_tail_) free_tail_ = o.free_tail_;
+    }
+    capacity_ += std::exchange(o.capacity_, 0);
+    o.blocks_tail_ = o.free_ = o.free_tail_ = nullptr;
+  }
+};
 
 template <class T, class Compare = std::less<T>>
 requires std::strict_weak_order<Compare, const T&, const T&>
@@ -14,24 +122,65 @@ private:
   struct Node {
     T key;
     int npl = 1;
-    std::unique_ptr<Node> left{}, right{};
-    explicit Node(T v) : key(std::move(v)) {}
+    Node* left = nullptr;
+    Node* right = nullptr;
+    template <class... Args>
+    explicit Node(std::in_place_t, Args&&... args) : key(std::forward<Args>(args)...) {}
   };
 
-  std::unique_ptr<Node> root{};
+  NodePool<Node> pool{};
+  Node* root = nullptr;
   std::size_t count_ = 0;
   [[no_unique_address]] Compare comp{};
+  [[no_unique_address]] stats_counter counters{};
 
-  static int nplOf(const std::unique_ptr<Node>& p) noexcept { return p ? p->npl : 0; }
+  static int nplOf(const Node* p) noexcept { return p ? p->npl : 0; }
 
-  static std::unique_ptr<Node> mergeNodes(std::unique_ptr<Node> a, std::unique_ptr<Node> b, Compare comp) {
+  // Two passes over the right spines: the first walks down merging them and
+  // reverses the visited nodes into a chain through their right links, the
+  // second walks that chain back up restoring the leftist property.
+  Node* mergeNodes(Node* a, Node* b) {
     if (!a) return b;
     if (!b) return a;
-    if (comp(b->key, a->key)) a.swap(b);
-    a->right = mergeNodes(std::move(a->right), std::move(b), comp);
-    if (nplOf(a->left) < nplOf(a->right)) a->left.swap(a->right);
-    a->npl = nplOf(a->right) + 1;
-    return a;
+    Node* path = nullptr;
+    std::uint64_t depth = 0;
+    while (a && b) {
+      counters.compare();
+      counters.visit();
+      ++depth;
+      if (comp(b->key, a->key)) std::swap(a, b);
+      Node* next = a->right;
+      a->right = path;
+      path = a;
+      a = next;
+    }
+    counters.depth(depth);
+    Node* rest = a ? a : b;
+    while (path) {
+      Node* up = path->right;
+      path->right = rest;
+      if (nplOf(path->left) < nplOf(rest)) std::swap(path->left, path->right);
+      path->npl = nplOf(path->right) + 1;
+      rest = path;
+      path = up;
+    }
+    return rest;
+  }
+
+  // Rotates left children up so every node is freed with its left subtree
+  // empty; constant extra space regardless of shape.
+  void destroyNodes(Node* n) noexcept {
+    while (n) {
+      if (Node* l = n->left) {
+        n->left = l->right;
+        l->right = n;
+        n = l;
+      } else {
+        Node* r = n->right;
+        pool.destroy(n);
+        n = r;
+      }
+    }
   }
 
 public:
@@ -40,15 +189,63 @@ public:
   LeftistHeap() = default;
   explicit LeftistHeap(Compare cmp) : comp(std::move(cmp)) {}
 
+  LeftistHeap(LeftistHeap&& o) noexcept
+    : pool(std::move(o.pool)), root(std::exchange(o.root, nullptr)), count_(std::exchange(o.count_, 0)), comp(std::move(o.comp)) {}
+  LeftistHeap& operator=(LeftistHeap&& o) noexcept {
+    if (this != &o) {
+      destroyNodes(root);
+      pool = std::move(o.pool);
+      root = std::exchange(o.root, nullptr);
+      count_ = std::exchange(o.count_, 0);
+      comp = std::move(o.comp);
+    }
+    return *this;
+  }
+  ~LeftistHeap() { destroyNodes(root); }
+
+  // Linear-time build: Floyd's heapify orders the elements as an implicit
+  // binary heap, which is then laid out in one run of nodes and linked. A
+  // complete tree in heap order is already leftist, since no left subtree
+  // is shorter than its right sibling.
   template <std::ranges::input_range R>
   requires std::convertible_to<std::ranges::range_value_t<R>, T>
   explicit LeftistHeap(R&& r, Compare cmp = {}) : comp(std::move(cmp)) {
-    for (auto&& x : r) push(static_cast<T>(std::forward<decltype(x)>(x)));
+    std::vector<T> keys;
+    if constexpr (std::ranges::sized_range<R>) keys.reserve(std::ranges::size(r));
+    for (auto&& x : r) keys.push_back(static_cast<T>(std::forward<decltype(x)>(x)));
+    const std::size_t n = keys.size();
+    if (!n) return;
+    std::ranges::make_heap(keys, [this](const T& a, const T& b) { return comp(b, a); });
+
+    Node* nodes = pool.allocate_run(n);
+    std::size_t built = 0;
+    try {
+      for (; built < n; ++built) ::new (static_cast<void*>(nodes + built)) Node(std::in_place, std::move(keys[built]));
+    } catch (...) {
+      for (std::size_t i = 0; i < n; ++i) i < built ? pool.destroy(nodes + i) : pool.deallocate(nodes + i);
+      throw;
+    }
+    for (std::size_t i = n; i-- > 0; ) {
+      Node* p = nodes + i;
+      if (2 * i + 1 < n) p->left = nodes + 2 * i + 1;
+      if (2 * i + 2 < n) p->right = nodes + 2 * i + 2;
+      p->npl = nplOf(p->right) + 1;
+    }
+    count_ = n;
+    root = nodes;
   }
 
   [[nodiscard]] bool empty() const noexcept { return count_ == 0; }
   [[nodiscard]] std::size_t size() const noexcept { return count_; }
 
+  // Comparisons and nodes walked on merge paths, node allocations and the
+  // longest merge path; all zero unless built with DSA_STATS.
+  [[nodiscard]] container_stats stats() const noexcept { return counters.get(); }
+  void reset_stats() noexcept { counters.reset(); }
+
+  // Preallocates one block of n nodes for later pushes.
+  void reserve(std::size_t n) { if (n) pool.grow(n); }
+
   [[nodiscard]] const T& top() const {
     if (!root) throw std::runtime_error("LeftistHeap::top on empty heap");
     return root->key;
@@ -59,17 +256,18 @@ public:
 
   template<class... Args>
   T& emplace(Args&&... args) {
-    auto single = std::make_unique<Node>(T(std::forward<Args>(args)...));
-    root = mergeNodes(std::move(root), std::move(single), comp);
+    Node* single = pool.create(std::in_place, std::forward<Args>(args)...);
+    counters.allocate();
+    root = mergeNodes(root, single);
     ++count_;
-    return root->key;
+    return single->key;
   }
 
   void pop() {
     if (!root) throw std::runtime_error("LeftistHeap::pop on empty heap");
-    auto l = std::move(root->left);
-    auto r = std::move(root->right);
-    root = mergeNodes(std::move(l), std::move(r), comp);
+    Node* old = root;
+    root = mergeNodes(old->left, old->right);
+    pool.destroy(old);
     --count_;
   }
 
@@ -82,14 +280,17 @@ public:
 
   void merge(LeftistHeap& other) {
     if (this == &other) return;
-    root = mergeNodes(std::move(root), std::move(other.root), comp);
+    pool.splice(other.pool);
+    root = mergeNodes(root, std::exchange(other.root, nullptr));
     count_ += std::exchange(other.count_, 0);
   }
 
   void merge(LeftistHeap&& other) { merge(other); }
 
+  // Keeps the nodes for reuse by later pushes.
   void clear() noexcept {
-    root.reset();
+    destroyNodes(root);
+    root = nullptr;
     count_ = 0;
   }
 };
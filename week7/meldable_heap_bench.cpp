@@ -0,0 +1,169 @@
+#include <bits/stdc++.h>
+#include "leftist_heap.cpp"
+#include "pairing_heap.cpp"
+#include "skew_heap.cpp"
+
+using u64 = unsigned long long;
+
+template <class F>
+double millis(F&& f) {
+  const auto t0 = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void row(std::string_view name, std::string_view what, double mops, u64 check, bool ok = true) {
+  std::cout << std::left << std::setw(14) << name << std::setw(12) << what << std::right << std::fixed
+            << std::setprecision(1) << std::setw(8) << mops << " Mops/s" << (ok ? "" : "  WRONG") << "  ("
+            << (check & 0xff) << ")\n";
+}
+
+// n pushes of random keys, then n pops.
+template <class H>
+void run_push_pop(std::string_view name, std::size_t n) {
+  std::mt19937_64 rng(n);
+  H h;
+  const double push = millis([&] { for (std::size_t i = 0; i < n; ++i) h.push(rng()); });
+  u64 check = 0, prev = 0;
+  bool ok = true;
+  const double pop = millis([&] {
+    while (!h.empty()) {
+      const u64 x = h.extractTop();
+      ok &= x >= prev;
+      prev = x;
+      check += x;
+    }
+  });
+  row(name, "push", n / push / 1e3, 0);
+  row(name, "pop", n / pop / 1e3, check, ok);
+}
+
+// n singleton heaps melded pairwise in rounds down to one, then drained.
+template <class H>
+void run_mass_meld(std::string_view name, std::size_t n) {
+  std::mt19937_64 rng(n);
+  std::vector<H> heaps(n);
+  for (auto& h : heaps) h.push(rng());
+  const double meld = millis([&] {
+    for (std::size_t live = n; live > 1; live = (live + 1) / 2)
+      for (std::size_t i = 0; i < live / 2; ++i) heaps[i].merge(heaps[live - 1 - i]);
+  });
+  u64 check = 0;
+  const double drain = millis([&] { while (!heaps[0].empty()) check += heaps[0].extractTop(); });
+  row(name, "meld", (n - 1) / meld / 1e3, 0, heaps[0].empty());
+  row(name, "drain", n / drain / 1e3, check);
+}
+
+// Mixed trace over 64 queues, as in per-worker schedulers that steal by
+// melding: 45% push, 45% pop, 10% meld of one queue into another.
+template <class H>
+void run_mixed(std::string_view name, std::size_t ops) {
+  std::mt19937_64 rng(ops);
+  std::vector<H> heaps(64);
+  for (std::size_t i = 0; i < ops / 4; ++i) heaps[rng() % 64].push(rng() % 1'000'000);
+  u64 check = 0;
+  const double t = millis([&] {
+    for (std::size_t i = 0; i < ops; ++i) {
+      const unsigned p = rng() % 100;
+      H& h = heaps[rng() % 64];
+      if (p < 45) h.push(rng() % 1'000'000);
+      else if (p < 90) { if (!h.empty()) check += h.extractTop(); }
+      else h.merge(heaps[rng() % 64]);
+    }
+  });
+  row(name, "mixed", ops / t / 1e3, check);
+}
+
+// Dijkstra on a random sparse graph. PairingHeap uses decrease-key; the
+// other heaps push duplicates and skip stale entries on pop.
+template <class H>
+void run_dijkstra(std::string_view name, std::size_t n) {
+  std::mt19937_64 rng(n);
+  std::vector<std::vector<std::pair<std::uint32_t, u64>>> adj(n);
+  for (std::size_t v = 0; v < n; ++v)
+    for (int e = 0; e < 8; ++e) adj[v].emplace_back(rng() % n, 1 + rng() % 1000);
+  std::vector<u64> dist(n, ~0ULL);
+  using Item = std::pair<u64, std::uint32_t>;
+  u64 relax = 0;
+  const double t = millis([&] {
+    H h;
+    dist[0] = 0;
+    if constexpr (requires (H q, Item x) { q.decrease(q.push(x), x); }) {
+      std::vector<typename H::handle> where(n);
+      std::vector<char> queued(n, 0);
+      where[0] = h.push({0, 0});
+      queued[0] = 1;
+      while (!h.empty()) {
+        const auto [d, v] = h.extractTop();
+        queued[v] = 0;
+        for (auto [w, c] : adj[v]) {
+          if (d + c >= dist[w]) continue;
+          dist[w] = d + c;
+          ++relax;
+          if (queued[w]) h.decrease(where[w], {dist[w], w});
+          else { where[w] = h.push({dist[w], w}); queued[w] = 1; }
+        }
+      }
+    } else {
+      h.push({0, 0});
+      while (!h.empty()) {
+        const auto [d, v] = h.extractTop();
+        if (d != dist[v]) continue;
+        for (auto [w, c] : adj[v]) {
+          if (d + c >= dist[w]) continue;
+          dist[w] = d + c;
+          ++relax;
+          h.push({dist[w], w});
+        }
+      }
+    }
+  });
+  u64 check = 0;
+  for (u64 d : dist) if (d != ~0ULL) check += d;
+  row(name, "dijkstra", relax / t / 1e3, check);
+}
+
+// Range constructor against the push loop it replaces.
+void run_build(std::size_t n) {
+  std::mt19937_64 rng(n);
+  std::vector<u64> keys(n);
+  for (auto& k : keys) k = rng();
+  LeftistHeap<u64> a, b;
+  const double loop = millis([&] { for (u64 k : keys) a.push(k); });
+  const double bulk = millis([&] { b = LeftistHeap<u64>(keys); });
+  bool ok = a.size() == b.size();
+  for (int i = 0; i < 1000 && !a.empty(); ++i) ok &= a.extractTop() == b.extractTop();
+  std::cout << std::fixed << std::setprecision(1) << "LeftistHeap build " << n << ": push loop " << loop
+            << " ms, range constructor " << bulk << " ms" << (ok ? "" : "  WRONG") << '\n';
+}
+
+// Keys pushed in decreasing order leave LeftistHeap with a left path as long
+// as the heap; destroying it must not recurse.
+void run_degenerate(std::size_t n) {
+  LeftistHeap<u64> h;
+  for (std::size_t i = n; i > 0; --i) h.push(i);
+  const double t = millis([&] { h.clear(); });
+  std::cout << std::fixed << std::setprecision(1) << "clear of a " << n << "-deep LeftistHeap: " << t << " ms\n";
+}
+
+template <template <class, class> class H>
+void run_all(std::string_view name, std::size_t n) {
+  run_push_pop<H<u64, std::less<u64>>>(name, n);
+  run_mass_meld<H<u64, std::less<u64>>>(name, n);
+  run_mixed<H<u64, std::less<u64>>>(name, 4 * n);
+  run_dijkstra<H<std::pair<u64, std::uint32_t>, std::less<std::pair<u64, std::uint32_t>>>>(name, n / 4);
+}
+
+int main(int argc, char** argv) {
+  std::ios::sync_with_stdio(false);
+  std::cin.tie(nullptr);
+  std::cout.tie(nullptr);
+
+  const std::size_t n = argc > 1 ? std::stoull(argv[1]) : 2'000'000;
+  run_all<LeftistHeap>("LeftistHeap", n);
+  run_all<SkewHeap>("SkewHeap", n);
+  run_all<PairingHeap>("PairingHeap", n);
+  run_build(n);
+  run_degenerate(n);
+  return 0;
+}
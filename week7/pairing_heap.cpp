@@ -0,0 +1,197 @@
+#pragma once
+#include "leftist_heap.cpp"
+
+// Pairing heap with the LeftistHeap interface plus decrease-key. push and
+// merge are O(1), pop is O(log n) amortized. Each node keeps its first child,
+// its next sibling and a back link to its left sibling (or to its parent
+// when it is a first child), so a node can be cut out in O(1).
+template <class T, class Compare = std::less<T>>
+requires std::strict_weak_order<Compare, const T&, const T&>
+class PairingHeap {
+private:
+  struct Node {
+    T key;
+    Node* child = nullptr;
+    Node* sibling = nullptr;
+    Node* prev = nullptr;
+    template <class... Args>
+    explicit Node(std::in_place_t, Args&&... args) : key(std::forward<Args>(args)...) {}
+  };
+
+  NodePool<Node> pool{};
+  Node* root = nullptr;
+  std::size_t count_ = 0;
+  [[no_unique_address]] Compare comp{};
+
+  // Links two detached roots; the loser becomes the winner's first child.
+  Node* link(Node* a, Node* b) {
+    if (comp(b->key, a->key)) std::swap(a, b);
+    b->prev = a;
+    b->sibling = a->child;
+    if (a->child) a->child->prev = b;
+    a->child = b;
+    return a;
+  }
+
+  // Standard two-pass pairing of a sibling list: link neighbours left to
+  // right, then fold the pairs right to left. The first pass chains the
+  // pairs in reverse through their sibling links.
+  Node* combine(Node* first) {
+    Node* pairs = nullptr;
+    while (first) {
+      Node* a = first;
+      Node* b = a->sibling;
+      first = b ? b->sibling : nullptr;
+      a->sibling = a->prev = nullptr;
+      if (b) {
+        b->sibling = b->prev = nullptr;
+        a = link(a, b);
+      }
+      a->sibling = pairs;
+      pairs = a;
+    }
+    Node* acc = pairs;
+    if (!acc) return nullptr;
+    pairs = std::exchange(acc->sibling, nullptr);
+    while (pairs) {
+      Node* next = std::exchange(pairs->sibling, nullptr);
+      acc = link(acc, pairs);
+      pairs = next;
+    }
+    return acc;
+  }
+
+  Node* meld(Node* a, Node* b) {
+    if (!a) return b;
+    if (!b) return a;
+    return link(a, b);
+  }
+
+  // Frees a node's children before moving on to its sibling, splicing the
+  // child list in front of the remaining siblings; constant extra space.
+  void destroyNodes(Node* n) noexcept {
+    while (n) {
+      if (Node* c = n->child) {
+        Node* last = c;
+        while (last->sibling) last = last->sibling;
+        last->sibling = n->sibling;
+        n->sibling = c;
+        n->child = nullptr;
+      }
+      Node* next = n->sibling;
+      pool.destroy(n);
+      n = next;
+    }
+  }
+
+public:
+  using value_type = T;
+
+  // Refers to one pushed element until it is popped or the heap is cleared;
+  // stays valid when its heap is merged into another one.
+  class handle {
+    Node* n = nullptr;
+    friend class PairingHeap;
+    explicit handle(Node* p) noexcept : n(p) {}
+  public:
+    handle() = default;
+    friend bool operator==(handle, handle) = default;
+  };
+
+  PairingHeap() = default;
+  explicit PairingHeap(Compare cmp) : comp(std::move(cmp)) {}
+
+  PairingHeap(PairingHeap&& o) noexcept
+    : pool(std::move(o.pool)), root(std::exchange(o.root, nullptr)), count_(std::exchange(o.count_, 0)), comp(std::move(o.comp)) {}
+  PairingHeap& operator=(PairingHeap&& o) noexcept {
+    if (this != &o) {
+      destroyNodes(root);
+      pool = std::move(o.pool);
+      root = std::exchange(o.root, nullptr);
+      count_ = std::exchange(o.count_, 0);
+      comp = std::move(o.comp);
+    }
+    return *this;
+  }
+  ~PairingHeap() { destroyNodes(root); }
+
+  template <std::ranges::input_range R>
+  requires std::convertible_to<std::ranges::range_value_t<R>, T>
+  explicit PairingHeap(R&& r, Compare cmp = {}) : comp(std::move(cmp)) {
+    for (auto&& x : r) push(static_cast<T>(std::forward<decltype(x)>(x)));
+  }
+
+  [[nodiscard]] bool empty() const noexcept { return count_ == 0; }
+  [[nodiscard]] std::size_t size() const noexcept { return count_; }
+
+  void reserve(std::size_t n) { if (n) pool.grow(n); }
+
+  [[nodiscard]] const T& top() const {
+    if (!root) throw std::runtime_error("PairingHeap::top on empty heap");
+    return root->key;
+  }
+  [[nodiscard]] handle top_handle() const {
+    if (!root) throw std::runtime_error("PairingHeap::top_handle on empty heap");
+    return handle(root);
+  }
+
+  [[nodiscard]] const T& operator[](handle h) const noexcept { return h.n->key; }
+
+  handle push(const T& v) { return handle(insert(v)); }
+  handle push(T&& v) { return handle(insert(std::move(v))); }
+
+  template<class... Args>
+  T& emplace(Args&&... args) { return insert(std::forward<Args>(args)...)->key; }
+
+  // Replaces the key of h with one that compares no worse.
+  void decrease(handle h, T v) {
+    Node* n = h.n;
+    if (comp(n->key, v)) throw std::invalid_argument("PairingHeap::decrease to a worse key");
+    n->key = std::move(v);
+    if (n == root) return;
+    if (n->prev->child == n) n->prev->child = n->sibling;
+    else n->prev->sibling = n->sibling;
+    if (n->sibling) n->sibling->prev = n->prev;
+    n->sibling = n->prev = nullptr;
+    root = link(root, n);
+  }
+
+  void pop() {
+    if (!root) throw std::runtime_error("PairingHeap::pop on empty heap");
+    Node* old = root;
+    root = combine(old->child);
+    pool.destroy(old);
+    --count_;
+  }
+
+  [[nodiscard]] T extractTop() {
+    if (!root) throw std::runtime_error("PairingHeap::extractTop on empty heap");
+    T res = std::move(root->key);
+    pop();
+    return res;
+  }
+
+  void merge(PairingHeap& other) {
+    if (this == &other) return;
+    pool.splice(other.pool);
+    root = meld(root, std::exchange(other.root, nullptr));
+    count_ += std::exchange(other.count_, 0);
+  }
+
+  void merge(PairingHeap&& other) { merge(other); }
+
+  void clear() noexcept {
+    destroyNodes(root);
+    root = nullptr;
+    count_ = 0;
+  }
+
+private:
+  template<class... Args>
+  Node* insert(Args&&... args) {
+    Node* single = pool.create(std::in_place, std::forward<Args>(args)...);
+    root = meld(root, single);
+    ++count_;
+    return single;
+  }
+};
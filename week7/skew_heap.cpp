@@ -0,0 +1,131 @@
+#pragma once
+#include "leftist_heap.cpp"
+
+// Self-adjusting variant of LeftistHeap: no rank is stored, and every node on
+// the merge path swaps its children instead. Merge is O(log n) amortized and
+// can be O(n) for a single call, but it touches less memory per node.
+template <class T, class Compare = std::less<T>>
+requires std::strict_weak_order<Compare, const T&, const T&>
+class SkewHeap {
+private:
+  struct Node {
+    T key;
+    Node* left = nullptr;
+    Node* right = nullptr;
+    template <class... Args>
+    explicit Node(std::in_place_t, Args&&... args) : key(std::forward<Args>(args)...) {}
+  };
+
+  NodePool<Node> pool{};
+  Node* root = nullptr;
+  std::size_t count_ = 0;
+  [[no_unique_address]] Compare comp{};
+
+  // Top-down: the winner of each step keeps its old left child as its new
+  // right one, and the rest of the merge goes into its left link.
+  Node* mergeNodes(Node* a, Node* b) {
+    Node* res = nullptr;
+    Node** hole = &res;
+    while (a && b) {
+      if (comp(b->key, a->key)) std::swap(a, b);
+      *hole = a;
+      Node* next = a->right;
+      a->right = a->left;
+      hole = &a->left;
+      a = next;
+    }
+    *hole = a ? a : b;
+    return res;
+  }
+
+  void destroyNodes(Node* n) noexcept {
+    while (n) {
+      if (Node* l = n->left) {
+        n->left = l->right;
+        l->right = n;
+        n = l;
+      } else {
+        Node* r = n->right;
+        pool.destroy(n);
+        n = r;
+      }
+    }
+  }
+
+public:
+  using value_type = T;
+
+  SkewHeap() = default;
+  explicit SkewHeap(Compare cmp) : comp(std::move(cmp)) {}
+
+  SkewHeap(SkewHeap&& o) noexcept
+    : pool(std::move(o.pool)), root(std::exchange(o.root, nullptr)), count_(std::exchange(o.count_, 0)), comp(std::move(o.comp)) {}
+  SkewHeap& operator=(SkewHeap&& o) noexcept {
+    if (this != &o) {
+      destroyNodes(root);
+      pool = std::move(o.pool);
+      root = std::exchange(o.root, nullptr);
+      count_ = std::exchange(o.count_, 0);
+      comp = std::move(o.comp);
+    }
+    return *this;
+  }
+  ~SkewHeap() { destroyNodes(root); }
+
+  template <std::ranges::input_range R>
+  requires std::convertible_to<std::ranges::range_value_t<R>, T>
+  explicit SkewHeap(R&& r, Compare cmp = {}) : comp(std::move(cmp)) {
+    for (auto&& x : r) push(static_cast<T>(std::forward<decltype(x)>(x)));
+  }
+
+  [[nodiscard]] bool empty() const noexcept { return count_ == 0; }
+  [[nodiscard]] std::size_t size() const noexcept { return count_; }
+
+  void reserve(std::size_t n) { if (n) pool.grow(n); }
+
+  [[nodiscard]] const T& top() const {
+    if (!root) throw std::runtime_error("SkewHeap::top on empty heap");
+    return root->key;
+  }
+
+  void push(const T& v) { emplace(v); }
+  void push(T&& v) { emplace(std::move(v)); }
+
+  template<class... Args>
+  T& emplace(Args&&... args) {
+    Node* single = pool.create(std::in_place, std::forward<Args>(args)...);
+    root = mergeNodes(root, single);
+    ++count_;
+    return single->key;
+  }
+
+  void pop() {
+    if (!root) throw std::runtime_error("SkewHeap::pop on empty heap");
+    Node* old = root;
+    root = mergeNodes(old->left, old->right);
+    pool.destroy(old);
+    --count_;
+  }
+
+  [[nodiscard]] T extractTop() {
+    if (!root) throw std::runtime_error("SkewHeap::extractTop on empty heap");
+    T res = std::move(root->key);
+    pop();
+    return res;
+  }
+
+  void merge(SkewHeap& other) {
+    if (this == &other) return;
+    pool.splice(other.pool);
+    root = mergeNodes(root, std::exchange(other.root, nullptr));
+    count_ += std::exchange(other.count_, 0);
+  }
+
+  void merge(SkewHeap&& other) { merge(other); }
+
+  void clear() noexcept {
+    destroyNodes(root);
+    root = nullptr;
+    count_ = 0;
+  }
+};